@@ -0,0 +1,160 @@
+/* Check the results of linear algebra applications */
+
+#include "../source/alat.h"
+
+static int failures = 0;
+
+// Display the result of a check and count the failed ones.
+static void check(bool_t passed, str_t name)
+{
+   printf("%-40s %s\n", name, passed ? "ok" : "FAILED");
+   failures += !passed;
+}
+
+// Cubic which the splines of not-a-knot and clamped ends must reproduce.
+static double cubic(double x)
+{
+   return ((0.5 * x - 2.0) * x + 1.0) * x - 3.0;
+}
+
+// First derivative of the cubic for clamped ends.
+static double slope(double x)
+{
+   return (1.5 * x - 4.0) * x + 1.0;
+}
+
+void main(int argc, char *argv[])
+{
+   // Evaluation must match Horner steps of the coefficients.
+   vector_t coefs = {.dim = 4, .vector = {-3.0, 1.0, -2.0, 0.5}};
+   size_t count = 1001;
+   double *x = malloc(sizeof(double) * count);
+   double *result = malloc(sizeof(double) * count);
+   bool_t passed = true;
+
+   for (size_t i = 0; i < count; i++)
+      x[i] = -4.0 + 10.0 * i / (count - 1);
+   apps_poly_eval(result, x, count, &coefs);
+   for (size_t i = 0; i < count; i++)
+      passed = passed && fabs(result[i] - cubic(x[i])) < 1e-12;
+   check(passed, "poly_eval");
+
+   // Splines pass through their knots for all ends, and not-a-knot and
+   // clamped ends reproduce cubics on uneven knots.
+   double knots[7] = {-4.0, -3.1, -1.0, 0.5, 0.7, 3.0, 6.0}, values[7];
+   for (int i = 0; i < 7; i++)
+      values[i] = cubic(knots[i]);
+
+   splineend_t ends[3] = {SPLINE_NATURAL, SPLINE_CLAMPED, SPLINE_NOTAKNOT};
+   for (int e = 0; e < 3; e++) {
+      spline_t *spline = apps_spline(knots, values, 7, ends[e],
+                                     slope(knots[0]), slope(knots[6]));
+      double fitted[7];
+
+      apps_spline_eval(fitted, knots, 7, spline);
+      passed = true;
+      for (int i = 0; i < 7; i++)
+         passed = passed && fabs(fitted[i] - values[i]) < 1e-12;
+
+      apps_spline_eval(result, x, count, spline);
+      if (ends[e] == SPLINE_NATURAL) {
+         // Second derivative at first knot is exact difference of cubic.
+         double h = 0.01, steps[4] = {-4.0, -4.0 + h, -4.0 + 2 * h,
+                                      -4.0 + 3 * h}, curve[4];
+
+         apps_spline_eval(curve, steps, 4, spline);
+         passed = passed && fabs((2 * curve[0] - 5 * curve[1] +
+                                  4 * curve[2] - curve[3]) / (h * h)) < 1e-6;
+      }
+      else {
+         for (size_t i = 0; i < count; i++)
+            passed = passed && fabs(result[i] - cubic(x[i])) < 1e-11;
+      }
+      check(passed, (e == 0) ? "natural spline" : (e == 1) ?
+                    "clamped spline" : "not-a-knot spline");
+      apps_spline_free(spline);
+   }
+
+   // Accumulators split between streams must recover the exact model, and
+   // zero weights must drop points.
+   size_t points = 500;
+   double *features = malloc(sizeof(double) * points * 2);
+   double *targets = malloc(sizeof(double) * points);
+   double *weights = malloc(sizeof(double) * points);
+   double model[5] = {1.0, 2.0, -0.5, 3.0, 0.25}, solved[5], residual;
+
+   for (size_t i = 0; i < points; i++) {
+      double a = sin(i * 0.37) * 3.0, b = cos(i * 0.53) * 2.0;
+
+      features[2*i] = a, features[2*i+1] = b;
+      targets[i] = model[0] + model[1] * a + model[2] * a * a +
+                   model[3] * b + model[4] * b * b;
+      weights[i] = (i % 10 == 0) ? 0.0 : 1.0 + (i % 3);
+   }
+
+   lsq_t *first = apps_lsq(2, 2), *second = apps_lsq(2, 2);
+   apps_lsq_update(first, features, targets, NULL, 200);
+   apps_lsq_update(second, features + 400, targets + 200, NULL, 300);
+   apps_lsq_merge(first, second);
+   residual = apps_lsq_solve(first, solved);
+
+   passed = residual < 1e-16 * points;
+   for (int i = 0; i < 5; i++)
+      passed = passed && fabs(solved[i] - model[i]) < 1e-10;
+   check(passed, "lsq update, merge and solve");
+
+   // Outliers have zero weights, so they don't move the fit.
+   for (size_t i = 0; i < points; i += 10)
+      targets[i] += 1e3;
+
+   lsq_t *weighted = apps_lsq(2, 2);
+   apps_lsq_update(weighted, features, targets, weights, points);
+   residual = apps_lsq_solve(weighted, solved);
+   passed = residual < 1e-16 * points;
+   for (int i = 0; i < 5; i++)
+      passed = passed && fabs(solved[i] - model[i]) < 1e-10;
+   check(passed, "weighted lsq");
+   apps_lsq_free(first), apps_lsq_free(second), apps_lsq_free(weighted);
+
+   // Regression line through exact points is the line itself.
+   vector_t xvector = {.dim = 5, .vector = {-1, 0, 2, 3, 7}};
+   vector_t yvector = {.dim = 5, .vector = {-1.5, 0.5, 4.5, 6.5, 14.5}};
+   vector_t line = apps_least_sqaures_reg(xvector, yvector);
+   check(fabs(line.vector[0] - 0.5) < 1e-12 &&
+         fabs(line.vector[1] - 2.0) < 1e-12, "least squares regression");
+
+   // Unit cube has surface 6 in 12 triangles and volume 1 in 6 equal
+   // tetrahedrons. Vertex i has x, y and z from bits of i.
+   double cube[8 * 3];
+   for (int i = 0; i < 8; i++)
+      cube[3*i] = i & 1, cube[3*i+1] = (i >> 1) & 1, cube[3*i+2] = (i >> 2) & 1;
+
+   size_t faces[12 * 3] = {
+      0, 1, 3, 0, 3, 2, 4, 5, 7, 4, 7, 6, 0, 1, 5, 0, 5, 4,
+      2, 3, 7, 2, 7, 6, 0, 2, 6, 0, 6, 4, 1, 3, 7, 1, 7, 5
+   };
+   size_t cells[6 * 4] = {
+      0, 1, 3, 7, 0, 1, 5, 7, 0, 2, 3, 7, 0, 2, 6, 7, 0, 4, 5, 7, 0, 4, 6, 7
+   };
+   double areas[12], volumes[6];
+
+   passed = fabs(apps_mesh_area(areas, cube, faces, 12) - 6.0) < 1e-15;
+   for (int i = 0; i < 12; i++)
+      passed = passed && fabs(areas[i] - 0.5) < 1e-15;
+   passed = passed && fabs(apps_mesh_volume(volumes, cube, cells, 6) - 1.0) <
+                      1e-15;
+   for (int i = 0; i < 6; i++)
+      passed = passed && fabs(volumes[i] - 1.0 / 6.0) < 1e-15;
+   check(passed, "mesh area and volume");
+
+   // Single triangle and tetrahedron match the closed forms.
+   vector_t xcorners = {.dim = 3, .vector = {0, 4, 1}};
+   vector_t ycorners = {.dim = 3, .vector = {0, 0, 3}};
+   vector_t xtetra = {.dim = 4, .vector = {0, 2, 0, 0}};
+   vector_t ytetra = {.dim = 4, .vector = {0, 0, 3, 0}};
+   vector_t ztetra = {.dim = 4, .vector = {0, 0, 0, 4}};
+   check(apps_area(xcorners, ycorners) == 6.0 &&
+         apps_volume(xtetra, ytetra, ztetra) == 4.0, "area and volume");
+
+   exit(failures ? EXIT_FAILURE : EXIT_SUCCESS);
+}
@@ -0,0 +1,239 @@
+/* Check the results of complex methods */
+
+#include "../source/alat.h"
+
+static int failures = 0;
+
+// Display the result of a check and count the failed ones.
+static void check(bool_t passed, str_t name)
+{
+   printf("%-40s %s\n", name, passed ? "ok" : "FAILED");
+   failures += !passed;
+}
+
+// Return true if complex values 'fz' and 'sz' are same within 'tol'.
+static bool_t close_to(cnum_t fz, cnum_t sz, double tol)
+{
+   return fabs(fz.re - sz.re) <= tol && fabs(fz.im - sz.im) <= tol;
+}
+
+// Return the largest difference of complex 'array' from the naive discrete
+// Fourier transform of 'input'.
+static double dft_error(const carray_t *array, const carray_t *input)
+{
+   double error = 0.0, re, im, angle;
+   size_t n = input->size;
+
+   for (size_t k = 0; k < n; k++) {
+      re = 0.0, im = 0.0;
+      for (size_t j = 0; j < n; j++) {
+         angle = -2.0 * M_PI * (double) ((j * k) % n) / n;
+         re += input->re[j] * cos(angle) - input->im[j] * sin(angle);
+         im += input->re[j] * sin(angle) + input->im[j] * cos(angle);
+      }
+      error = fmax(error, fmax(fabs(array->re[k] - re),
+                               fabs(array->im[k] - im)));
+   }
+
+   return error;
+}
+
+void main(int argc, char *argv[])
+{
+   cnum_t fz = complexes_cnum(3, 4), sz = complexes_cnum(-1, 2);
+
+   check(complexes_cabs(fz) == 5.0, "cabs");
+   check(fabs(complexes_carg(complexes_cnum(-1, -1)) + 135.0) < 1e-13,
+         "carg in degrees");
+   check(close_to(complexes_cnum_polar(2, 90), complexes_cnum(0, 2), 1e-15),
+         "cnum_polar");
+   check(close_to(complexes_cmul(fz, sz), complexes_cnum(-11, 2), 0) &&
+         close_to(complexes_cdiv(complexes_cmul(fz, sz), sz), fz, 1e-15),
+         "cmul and cdiv");
+   check(close_to(complexes_cadd(fz, complexes_csub(sz, fz)), sz, 0) &&
+         close_to(complexes_cmul(fz, complexes_crecip(fz)),
+                  complexes_cnum(1, 0), 1e-15) &&
+         close_to(complexes_cconj(fz), complexes_cnum(3, -4), 0),
+         "cadd, csub, crecip and cconj");
+   check(close_to(complexes_cpow(fz, 0.5), complexes_cnum(2, 1), 1e-14) &&
+         close_to(complexes_croot(complexes_cnum(-8, 0), 3),
+                  complexes_cnum(1, sqrt(3)), 1e-14), "cpow and croot");
+
+   complex_t polar = complexes_from_cnum(complexes_cnum(0, -2), FORM_POLAR);
+   check(polar.complex[0] == 2.0 && polar.complex[1] == -90.0 &&
+         close_to(complexes_to_cnum(polar), complexes_cnum(0, -2), 1e-15),
+         "to_cnum and from_cnum");
+
+   // All roots must give back the value when raised.
+   cnum_t roots[7];
+   bool_t raised = true;
+   complexes_croots(fz, 7, roots);
+   for (int i = 0; i < 7; i++)
+      raised = raised && close_to(complexes_cpowi(roots[i], 7), fz, 1e-13);
+   check(raised && close_to(complexes_cpowi(fz, 3), complexes_cnum(-117, 44),
+                            1e-12), "cpowi and croots");
+
+   // Array operations must match the scalar ones element by element.
+   size_t size = 1000;
+   carray_t farray = complexes_carray(size), sarray = complexes_carray(size);
+   carray_t result = complexes_carray(size), powered = complexes_carray(size);
+   double *modules = malloc(sizeof(double) * size);
+   double *arguments = malloc(sizeof(double) * size);
+
+   for (size_t i = 0; i < size; i++) {
+      farray.re[i] = sin(i * 0.37) * 10, farray.im[i] = cos(i * 0.11) * 10;
+      sarray.re[i] = 1 + i % 13, sarray.im[i] = -(double) (i % 7);
+   }
+   farray.re[0] = 1e200, farray.im[0] = -1e200;
+
+   bool_t arrays = true;
+   complexes_carray_multiply(&result, &farray, &sarray);
+   complexes_carray_divide(&result, &result, &sarray);
+   complexes_carray_power(&powered, &farray, 3);
+   complexes_carray_modules(modules, &farray);
+   complexes_carray_argument(arguments, &farray);
+
+   for (size_t i = 1; i < size; i++) {
+      cnum_t z = complexes_cnum(farray.re[i], farray.im[i]);
+
+      arrays = arrays &&
+         close_to(complexes_cnum(result.re[i], result.im[i]), z, 1e-13) &&
+         close_to(complexes_cnum(powered.re[i], powered.im[i]),
+                  complexes_cmul(complexes_cmul(z, z), z), 1e-10) &&
+         fabs(modules[i] - complexes_cabs(z)) < 1e-14 &&
+         fabs(arguments[i] - complexes_carg(z)) < 1e-12;
+   }
+   check(arrays, "carray operations");
+   check(fabs(modules[0] / (M_SQRT2 * 1e200) - 1.0) < 1e-15,
+         "carray modules out of square range");
+
+   complexes_carray_add(&result, &farray, &sarray);
+   complexes_carray_subtract(&result, &result, &sarray);
+   complexes_carray_conjugate(&result, &result);
+   complexes_carray_reciprocol(&powered, &sarray);
+   check(result.re[5] == farray.re[5] && result.im[5] == -farray.im[5] &&
+         close_to(complexes_cnum(powered.re[5], powered.im[5]),
+                  complexes_crecip(complexes_cnum(sarray.re[5],
+                                                  sarray.im[5])), 1e-16),
+         "carray add, conjugate and reciprocol");
+
+   // Squares of these values leave the range of doubles, but quotients and
+   // reciprocols don't.
+   carray_t fextreme = complexes_carray(2), sextreme = complexes_carray(2);
+   cnum_t quotients[2] = {complexes_cnum(0, 1), complexes_cnum(0.44, 0.08)};
+   cnum_t reciprocols[2] = {complexes_cnum(0.5, 0.5),
+                            complexes_cnum(1.2, -1.6)};
+   double scales[2] = {1e-300, 1e299};
+   bool_t extreme = true;
+
+   fextreme.re[0] = 1e300, fextreme.im[0] = 1e300;
+   sextreme.re[0] = 1e300, sextreme.im[0] = -1e300;
+   fextreme.re[1] = 1e-300, fextreme.im[1] = 2e-300;
+   sextreme.re[1] = 3e-300, sextreme.im[1] = 4e-300;
+
+   for (int i = 0; i < 2; i++) {
+      cnum_t fextremum = complexes_cnum(fextreme.re[i], fextreme.im[i]);
+      cnum_t sextremum = complexes_cnum(sextreme.re[i], sextreme.im[i]);
+      cnum_t recip = complexes_crecip(sextremum);
+
+      extreme = extreme &&
+         close_to(complexes_cdiv(fextremum, sextremum), quotients[i], 1e-15) &&
+         close_to(complexes_cnum(recip.re / scales[i], recip.im / scales[i]),
+                  reciprocols[i], 1e-15);
+   }
+
+   complexes_carray_divide(&fextreme, &fextreme, &sextreme);
+   complexes_carray_reciprocol(&sextreme, &sextreme);
+   for (int i = 0; i < 2; i++)
+      extreme = extreme &&
+         close_to(complexes_cnum(fextreme.re[i], fextreme.im[i]),
+                  quotients[i], 1e-15) &&
+         close_to(complexes_cnum(sextreme.re[i] / scales[i],
+                                 sextreme.im[i] / scales[i]),
+                  reciprocols[i], 1e-15);
+   check(extreme, "divide and reciprocol of extreme values");
+   complexes_carray_free(&fextreme), complexes_carray_free(&sextreme);
+
+   // Every root of the elements must give back the element when raised.
+   carray_t rooted = complexes_carray(size * 3);
+   complexes_carray_roots(&rooted, &farray, 3);
+   raised = true;
+   for (size_t i = 1; i < size; i++)
+      for (size_t k = 0; k < 3; k++)
+         raised = raised && close_to(complexes_cpowi(complexes_cnum(
+                  rooted.re[3*i+k], rooted.im[3*i+k]), 3),
+                  complexes_cnum(farray.re[i], farray.im[i]), 1e-12);
+   check(raised, "carray roots");
+
+   // Power-of-two and Bluestein sizes must match the naive transform, and
+   // the inverse must give back the input.
+   size_t sizes[3] = {256, 100, 17};
+   for (int s = 0; s < 3; s++) {
+      size_t n = sizes[s];
+      carray_t input = complexes_carray(n), output = complexes_carray(n);
+      fftplan_t *plan = complexes_fftplan(n, false);
+      double error = 0.0;
+
+      for (size_t i = 0; i < n; i++)
+         input.re[i] = sin(i * 1.3) + 0.5, input.im[i] = cos(i * i * 0.7);
+
+      complexes_fft(plan, &output, &input, false);
+      bool_t forward = dft_error(&output, &input) < 1e-12 * n;
+      complexes_fft(plan, &output, &output, true);
+      for (size_t i = 0; i < n; i++)
+         error = fmax(error, fmax(fabs(output.re[i] - input.re[i]),
+                                  fabs(output.im[i] - input.im[i])));
+
+      check(forward && error < 1e-14 * n, (n == 256) ? "fft of power of two" :
+            (n == 100) ? "fft of even size" : "fft of prime size");
+
+      complexes_fftplan_free(plan);
+      complexes_carray_free(&input);
+      complexes_carray_free(&output);
+   }
+
+   // Real transforms must match the complex transform of real input.
+   size_t n = 96;
+   double real[96], back[96];
+   carray_t input = complexes_carray(n), full = complexes_carray(n);
+   carray_t half = complexes_carray(n / 2 + 1);
+   fftplan_t *plan = complexes_fftplan(n, true);
+   fftplan_t *cplan = complexes_fftplan(n, false);
+   double error = 0.0;
+
+   for (size_t i = 0; i < n; i++)
+      real[i] = input.re[i] = exp(-0.05 * i) * cos(i * 0.9);
+
+   complexes_rfft(plan, &half, real);
+   complexes_fft(cplan, &full, &input, false);
+   complexes_irfft(plan, back, &half);
+   for (size_t i = 0; i <= n / 2; i++)
+      error = fmax(error, fmax(fabs(half.re[i] - full.re[i]),
+                               fabs(half.im[i] - full.im[i])));
+   for (size_t i = 0; i < n; i++)
+      error = fmax(error, fabs(back[i] - real[i]));
+   check(error < 1e-13, "rfft and irfft");
+
+   // Two dimensional transform of a single frequency is one peak.
+   size_t rows = 8, cols = 12;
+   carray_t grid = complexes_carray(rows * cols);
+   carray_t spectrum = complexes_carray(rows * cols);
+   bool_t peak = true;
+
+   for (size_t i = 0; i < rows; i++)
+      for (size_t j = 0; j < cols; j++)
+         grid.re[i*cols+j] = cos(2 * M_PI * (2.0 * i / rows + 3.0 * j / cols)),
+         grid.im[i*cols+j] = sin(2 * M_PI * (2.0 * i / rows + 3.0 * j / cols));
+
+   complexes_fft2(&spectrum, &grid, rows, cols, false);
+   for (size_t i = 0; i < rows * cols; i++)
+      peak = peak && close_to(complexes_cnum(spectrum.re[i], spectrum.im[i]),
+                              complexes_cnum((i == 2 * cols + 3) ?
+                                             rows * cols : 0, 0), 1e-12);
+   complexes_fft2(&spectrum, &spectrum, rows, cols, true);
+   peak = peak && close_to(complexes_cnum(spectrum.re[13], spectrum.im[13]),
+                           complexes_cnum(grid.re[13], grid.im[13]), 1e-14);
+   check(peak, "fft2");
+
+   exit(failures ? EXIT_FAILURE : EXIT_SUCCESS);
+}
@@ -0,0 +1,106 @@
+/* Check the round trips of cryptography methods */
+
+#include "../source/alat.h"
+
+static int failures = 0;
+
+// Display the result of a check and count the failed ones.
+static void check(bool_t passed, str_t name)
+{
+   printf("%-40s %s\n", name, passed ? "ok" : "FAILED");
+   failures += !passed;
+}
+
+// Run 'data' through a stream in chunks of 'step' bytes and return the
+// written size.
+static size_t run_stream(const crypts_key_t *key, bool_t decode,
+                         const unsigned char *data, size_t lenght,
+                         size_t step, unsigned char *output)
+{
+   crypts_stream_t stream;
+   size_t written = 0, size;
+
+   crypts_stream_init(&stream, key, decode, 2);
+   for (size_t i = 0; i < lenght; i += step) {
+      size = (lenght - i < step) ? lenght - i : step;
+      written += crypts_stream_update(&stream, data + i, size,
+                                      output + written);
+   }
+   written += crypts_stream_final(&stream, output + written);
+
+   return written;
+}
+
+void main(int argc, char *argv[])
+{
+   // The determinant of 'encoder' is 1, so it is invertible in any modulo.
+   matrix_t encoder = {
+      .shape = {3, 3},
+      .matrix = {
+         {1, 2, 3},
+         {0, 1, 4},
+         {5, 6, 0}
+      }
+   };
+
+   // Every residue must survive modular round trips, and the padding must
+   // always add one block at most.
+   unsigned char data[1000], encoded[1100], restored[1100];
+   unsigned char streamed[1100], unstreamed[1100];
+   unsigned int moduli[2] = {256, 251};
+
+   for (int m = 0; m < 2; m++) {
+      crypts_key_t modkey = crypts_modkey(encoder, moduli[m]);
+
+      for (int i = 0; i < 1000; i++)
+         data[i] = (unsigned char) ((i * 37 + i / 256) % moduli[m]);
+
+      size_t size = crypts_mod_encode(&modkey, data, 1000, encoded);
+      check(size == crypts_mod_size(&modkey, 1000) && size == 1002 &&
+            memcmp(encoded, data, 1000) != 0, moduli[m] == 256 ?
+            "mod encode modulo 256" : "mod encode modulo 251");
+
+      size_t back = crypts_mod_decode(&modkey, encoded, size, restored);
+      check(back == 1000 && !memcmp(restored, data, 1000),
+            moduli[m] == 256 ? "mod round trip modulo 256" :
+                               "mod round trip modulo 251");
+
+      // Streams must give the same bytes as one-shot calls for any chunks.
+      size_t ssize = run_stream(&modkey, false, data, 1000, 7, streamed);
+      size_t usize = run_stream(&modkey, true, streamed, ssize, 64,
+                                unstreamed);
+
+      check(ssize == size && !memcmp(streamed, encoded, size) &&
+            usize == 1000 && !memcmp(unstreamed, data, 1000),
+            moduli[m] == 256 ? "stream round trip modulo 256" :
+                               "stream round trip modulo 251");
+   }
+
+   // Precomputed keys must give back short messages.
+   str_t message = "Bad day";
+   crypts_key_t key = crypts_key(encoder);
+   str_t decoded = crypts_key_to_message(&key,
+                                         crypts_key_encode(&key, message));
+
+   check(key.det == 1.0, "key determinant");
+   check(!strcmp(decoded, message), "key round trip");
+   free(decoded);
+
+   // Batches of messages must give back each message.
+   str_t messages[3] = {"first", "", "a message longer than one block"};
+   str_t results[3];
+   size_t offsets[4];
+
+   double *rows = crypts_batch_encode(&key, 3, messages, offsets);
+   crypts_batch_to_messages(&key, 3, rows, offsets, results);
+
+   bool_t same = true;
+   for (int i = 0; i < 3; i++) {
+      same = same && !strcmp(results[i], messages[i]);
+      free(results[i]);
+   }
+   check(same, "batch round trip");
+   free(rows);
+
+   exit(failures ? EXIT_FAILURE : EXIT_SUCCESS);
+}
@@ -0,0 +1,154 @@
+/* Check the elementwise math methods in strict and fast modes */
+
+#include "../source/alat.h"
+
+static int failures = 0;
+
+// Display the result of a check and count the failed ones.
+static void check(bool_t passed, str_t name)
+{
+   printf("%-40s %s\n", name, passed ? "ok" : "FAILED");
+   failures += !passed;
+}
+
+// Return the largest error of 'n' elements of 'result' from 'expected',
+// relative to them (or absolute below 'floor').
+static double max_error(const double *result, const double *expected,
+                        size_t n, double floor)
+{
+   double error = 0.0, scale;
+
+   for (size_t i = 0; i < n; i++) {
+      if (result[i] == expected[i])
+         continue;
+      scale = fmax(fabs(expected[i]), floor);
+      error = fmax(error, fabs(result[i] - expected[i]) / scale);
+      if (result[i] != result[i] || expected[i] != expected[i])
+         error = INFINITY;
+   }
+
+   return error;
+}
+
+void main(int argc, char *argv[])
+{
+   size_t n = 5000;
+   double *x = malloc(sizeof(double) * n), *y = malloc(sizeof(double) * n);
+   double *result = malloc(sizeof(double) * n);
+   double *other = malloc(sizeof(double) * n);
+   double *expected = malloc(sizeof(double) * n);
+   double *cosines = malloc(sizeof(double) * n);
+
+   // Positive elements across many binades, some of them subnormal.
+   for (size_t i = 0; i < n; i++)
+      x[i] = exp((double) i / n * 80.0 - 40.0) * (1.0 + 0.37 * sin(i));
+   x[0] = 1e-310, x[1] = 1.0, x[2] = DBL_MAX;
+
+   // Angles in degrees, and coordinates in all quadrants with signed zeros.
+   for (size_t i = 0; i < n; i++)
+      y[i] = (i % 3) ? sin(i * 0.77) * 5.0 : -cos(i * 0.31) * 3.0;
+   y[3] = 0.0, y[4] = -0.0;
+
+   mathmode_t modes[2] = {MATH_STRICT, MATH_FAST};
+   for (int m = 0; m < 2; m++) {
+      // Fast kernels are accurate to a few ulp, strict ones are libm.
+      double tol = (modes[m] == MATH_FAST) ? 8 * DBL_EPSILON : DBL_EPSILON;
+      bool_t passed;
+
+      maths_set_mode(modes[m]);
+      passed = maths_get_mode() == modes[m];
+
+      maths_sqrt(result, x, n);
+      for (size_t i = 0; i < n; i++)
+         expected[i] = sqrt(x[i]);
+      passed = passed && max_error(result, expected, n, 0) == 0.0;
+
+      maths_cbrt(result, x, n);
+      for (size_t i = 0; i < n; i++)
+         expected[i] = cbrt(x[i]);
+      passed = passed && max_error(result, expected, n, 0) <= tol;
+
+      maths_log(result, x, n);
+      for (size_t i = 0; i < n; i++)
+         expected[i] = log(x[i]);
+      passed = passed && max_error(result, expected, n, 0) <= tol;
+
+      maths_exp(result, y, n);
+      for (size_t i = 0; i < n; i++)
+         expected[i] = exp(y[i]);
+      passed = passed && max_error(result, expected, n, 0) <= tol;
+
+      check(passed, (m == 0) ? "strict sqrt, cbrt, log, exp" :
+                               "fast sqrt, cbrt, log, exp");
+
+      // Exponents of exact rewrites, squaring and the general path. 1/3 is
+      // rewritten into cube roots.
+      double exponents[5] = {2.0, 1.0 / 3.0, 3.0, -2.5, 100.5};
+      passed = true;
+      for (int e = 0; e < 5; e++) {
+         maths_pow(result, x + 1000, exponents[e], 3000);
+         for (size_t i = 0; i < 3000; i++)
+            expected[i] = (e == 1) ? cbrt(x[1000+i]) : 
+                                     pow(x[1000+i], exponents[e]);
+         passed = passed && max_error(result, expected, 3000, 0) <= tol;
+      }
+      check(passed, (m == 0) ? "strict pow" : "fast pow");
+
+      // Zeros, infinities and NaNs as bases must give the values of libm.
+      double specials[5] = {0.0, -0.0, INFINITY, -INFINITY, NAN};
+      double powers[8] = {0.7, -0.7, 0.2, 1.0 / 3.0, 3.0, -3.0, 4.0, -2.5};
+      passed = true;
+      for (int e = 0; e < 8; e++) {
+         maths_pow(result, specials, powers[e], 5);
+         for (int i = 0; i < 5; i++) {
+            expected[i] = pow(specials[i], powers[e]);
+            passed = passed && (result[i] == expected[i] ?
+                     signbit(result[i]) == signbit(expected[i]) :
+                     isnan(result[i]) && isnan(expected[i]));
+         }
+      }
+      check(passed, (m == 0) ? "strict pow of zeros, infinities, NaNs" :
+                               "fast pow of zeros, infinities, NaNs");
+
+      // Angles in degrees are compared with libm on radians.
+      double angles[6] = {0.0, 90.0, 180.0, 270.0, -45.0, 720030.0};
+      maths_sincosd(result, cosines, angles, 6);
+      passed = result[1] == 1.0 && cosines[1] == 0.0 && result[2] == 0.0 &&
+               cosines[3] == 0.0 && fabs(result[5] - 0.5) < 1e-15;
+
+      for (size_t i = 0; i < n; i++)
+         other[i] = y[i] * 40.0;
+      maths_sincosd(result, cosines, other, n);
+      for (size_t i = 0; i < n; i++)
+         expected[i] = sin(RAD(other[i]));
+      passed = passed && max_error(result, expected, n, 1.0) <= 4 * tol;
+      for (size_t i = 0; i < n; i++)
+         expected[i] = cos(RAD(other[i]));
+      passed = passed && max_error(cosines, expected, n, 1.0) <= 4 * tol;
+
+      maths_atan2d(result, y, y + 1, n - 1);
+      for (size_t i = 0; i < n - 1; i++)
+         expected[i] = DEG(atan2(y[i], y[i+1]));
+      passed = passed && max_error(result, expected, n - 1, 1.0) <= 2 * tol &&
+               result[3] == 180.0;
+
+      for (size_t i = 0; i < n; i++)
+         other[i] = sin(i * 0.77);
+      maths_acosd(result, other, n);
+      for (size_t i = 0; i < n; i++)
+         expected[i] = DEG(acos(other[i]));
+      passed = passed && max_error(result, expected, n, 1.0) <= 2 * tol;
+
+      check(passed, (m == 0) ? "strict sincosd, atan2d, acosd" :
+                               "fast sincosd, atan2d, acosd");
+
+      maths_degrees(result, y, n);
+      maths_radians(result, result, n);
+      check(max_error(result, y, n, 0) <= 2 * DBL_EPSILON,
+            (m == 0) ? "strict degrees and radians" :
+                       "fast degrees and radians");
+   }
+   maths_set_mode(MATH_STRICT);
+
+   exit(failures ? EXIT_FAILURE : EXIT_SUCCESS);
+}
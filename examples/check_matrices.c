@@ -0,0 +1,189 @@
+/* Check the results of matrix methods */
+
+#include "../source/alat.h"
+
+static int failures = 0;
+
+// Display the result of a check and count the failed ones.
+static void check(bool_t passed, str_t name)
+{
+   printf("%-40s %s\n", name, passed ? "ok" : "FAILED");
+   failures += !passed;
+}
+
+// Return true if 'fmatrix' and 'smatrix' are same within 'tol' relative
+// to the largest element of 'smatrix'.
+static bool_t close_to(matrix_t fmatrix, matrix_t smatrix, double tol)
+{
+   double high = 1.0;
+
+   if (fmatrix.shape.row != smatrix.shape.row ||
+       fmatrix.shape.col != smatrix.shape.col)
+      return false;
+
+   for (int i = 0; i < smatrix.shape.row; i++)
+      for (int j = 0; j < smatrix.shape.col; j++)
+         if (fabs(smatrix.matrix[i][j]) > high)
+            high = fabs(smatrix.matrix[i][j]);
+
+   for (int i = 0; i < smatrix.shape.row; i++)
+      for (int j = 0; j < smatrix.shape.col; j++)
+         if (fabs(fmatrix.matrix[i][j] - smatrix.matrix[i][j]) > tol * high)
+            return false;
+
+   return true;
+}
+
+void main(int argc, char *argv[])
+{
+   // Integer matrices are reduced by Bareiss elimination, so singular ones
+   // give exactly zero instead of round-off.
+   matrix_t singular = {
+      .shape = {3, 3},
+      .matrix = {
+         {1, 2, 3},
+         {4, 5, 6},
+         {7, 8, 9}
+      }
+   };
+   matrix_t laplace = {
+      .shape = {4, 4},
+      .matrix = {
+         {2, -1, 0, 0},
+         {-1, 2, -1, 0},
+         {0, -1, 2, -1},
+         {0, 0, -1, 2}
+      }
+   };
+
+   check(matrices_isinteger(singular), "isinteger");
+   check(matrices_det(singular) == 0.0, "det of singular integers is zero");
+   check(matrices_rank(singular) == 2, "rank of singular integers");
+   check(matrices_det(laplace) == 5.0, "det of integers is exact");
+
+   // Determinants over 64-bit integers fall back to floating point.
+   shape_t shape = {4, 4};
+   matrix_t large = matrices_scaler_mul(matrices_identity(shape), 1e7);
+   large.matrix[0][1] = 3;
+
+   check(fabs(matrices_det(large) - 1e28) <= 1e28 * 1e-14,
+         "det falls back on overflow");
+
+   // Complex products and solutions must match their real expansions.
+   cmatrix_t fcomplex = matrices_complex(matrices_uniform(-5, 5, shape),
+                                         matrices_uniform(-5, 5, shape));
+   cmatrix_t scomplex = matrices_complex(matrices_uniform(-5, 5, shape),
+                                         matrices_uniform(-5, 5, shape));
+   cmatrix_t product = matrices_complex_cross_mul(fcomplex, scomplex);
+
+   check(close_to(product.re, matrices_subtract(
+            matrices_cross_mul(fcomplex.re, scomplex.re),
+            matrices_cross_mul(fcomplex.im, scomplex.im)), 1e-14) &&
+         close_to(product.im, matrices_add(
+            matrices_cross_mul(fcomplex.re, scomplex.im),
+            matrices_cross_mul(fcomplex.im, scomplex.re)), 1e-14),
+         "complex cross_mul");
+
+   cmatrix_t hermitian = matrices_complex_conj_transpose(fcomplex);
+   check(hermitian.re.matrix[1][2] == fcomplex.re.matrix[2][1] &&
+         hermitian.im.matrix[1][2] == -fcomplex.im.matrix[2][1],
+         "complex conj_transpose");
+
+   cmatrix_t sum = matrices_complex_subtract(
+      matrices_complex_add(fcomplex, scomplex), scomplex);
+   check(close_to(sum.re, fcomplex.re, 1e-15) &&
+         close_to(sum.im, fcomplex.im, 1e-15), "complex add and subtract");
+
+   // Solve A x = b, where b is found from known x.
+   shape_t column = {4, 1};
+   cmatrix_t known = matrices_complex(matrices_uniform(-5, 5, column),
+                                      matrices_uniform(-5, 5, column));
+   cmatrix_t target = matrices_complex_cross_mul(fcomplex, known);
+   cmatrix_t solved = matrices_complex_solve(matrices_complex(
+      matrices_concat(fcomplex.re, target.re, 1),
+      matrices_concat(fcomplex.im, target.im, 1)));
+
+   check(close_to(solved.re, known.re, 1e-9) &&
+         close_to(solved.im, known.im, 1e-9), "complex solve");
+
+   // Powers by squaring must match repeated products, also for inverse and
+   // triangular matrices.
+   matrix_t power = matrices_identity(shape);
+   for (int i = 0; i < 7; i++)
+      power = matrices_cross_mul(power, laplace);
+
+   check(close_to(matrices_matpow(laplace, 7), power, 1e-13), "matpow");
+   check(close_to(matrices_matpow(laplace, 0), matrices_identity(shape), 0),
+         "matpow to zero power");
+   check(close_to(matrices_cross_mul(matrices_matpow(laplace, -3),
+                                     matrices_matpow(laplace, 3)),
+                  matrices_identity(shape), 1e-12), "matpow of inverse");
+
+   matrix_t upper = {
+      .shape = {3, 3},
+      .matrix = {
+         {1, 2, -1},
+         {0, -2, 3},
+         {0, 0, 0.5}
+      }
+   };
+   shape_t small = {3, 3};
+   power = matrices_identity(small);
+   for (int i = 0; i < 5; i++)
+      power = matrices_cross_mul(power, upper);
+
+   check(close_to(matrices_matpow(upper, 5), power, 1e-14),
+         "matpow of triangle");
+
+   // The exponential of a rotation generator is the rotation, and of a
+   // nilpotent matrix its finite series.
+   matrix_t generator = {.shape = {2, 2}, .matrix = {{0, 10}, {-10, 0}}};
+   matrix_t rotation = {
+      .shape = {2, 2},
+      .matrix = {
+         {cos(10), sin(10)},
+         {-sin(10), cos(10)}
+      }
+   };
+   matrix_t nilpotent = {
+      .shape = {3, 3},
+      .matrix = {
+         {0, 1, 0},
+         {0, 0, 1},
+         {0, 0, 0}
+      }
+   };
+   matrix_t series = {
+      .shape = {3, 3},
+      .matrix = {
+         {1, 1, 0.5},
+         {0, 1, 1},
+         {0, 0, 1}
+      }
+   };
+   matrix_t diagonal = {.shape = {2, 2}, .matrix = {{1, 0}, {0, -2}}};
+   matrix_t exponents = {.shape = {2, 2}, .matrix = {{M_E, 0}, {0, exp(-2)}}};
+
+   check(close_to(matrices_expm(generator), rotation, 1e-12),
+         "expm of rotation generator");
+   check(close_to(matrices_expm(nilpotent), series, 1e-15),
+         "expm of nilpotent");
+   check(close_to(matrices_expm(diagonal), exponents, 1e-15),
+         "expm of diagonal");
+
+   // The chain product must match left-to-right products, and take the
+   // order (AB)C with 10*30*5 + 10*5*60 multiply-adds.
+   matrix_t chain[3] = {
+      matrices_uniform(-5, 5, (shape_t) {10, 30}),
+      matrices_uniform(-5, 5, (shape_t) {30, 5}),
+      matrices_uniform(-5, 5, (shape_t) {5, 60})
+   };
+   double flops;
+
+   check(close_to(matrices_multi_mul(3, chain, &flops),
+                  matrices_cross_mul(matrices_cross_mul(chain[0], chain[1]),
+                                     chain[2]), 1e-13), "multi_mul");
+   check(flops == 2.0 * (10 * 30 * 5 + 10 * 5 * 60), "multi_mul order");
+
+   exit(failures ? EXIT_FAILURE : EXIT_SUCCESS);
+}
@@ -0,0 +1,280 @@
+/* Check the results of vector methods */
+
+#include "../source/alat.h"
+
+static int failures = 0;
+
+// Display the result of a check and count the failed ones.
+static void check(bool_t passed, str_t name)
+{
+   printf("%-40s %s\n", name, passed ? "ok" : "FAILED");
+   failures += !passed;
+}
+
+// Return the squared distance between 'fpoint' and 'spoint' of 'dim'.
+static double sqdist(const double *fpoint, const double *spoint, dim_t dim)
+{
+   double total = 0.0;
+
+   for (int i = 0; i < dim; i++)
+      total += (fpoint[i] - spoint[i]) * (fpoint[i] - spoint[i]);
+
+   return total;
+}
+
+void main(int argc, char *argv[])
+{
+   // Handle vectors must give the same results inline and in heap.
+   dim_t dims[2] = {3, 9};
+   for (int d = 0; d < 2; d++) {
+      hvector_t fvector = vectors_hsequential(1, 9, dims[d]);
+      hvector_t svector = vectors_harbitrary(2.0, dims[d]);
+      hvector_t result = vectors_hzeros(dims[d]);
+      hvector_t copy = vectors_hcopy(&fvector);
+      vector_t plain = {.dim = dims[d]};
+      double total = 0.0;
+
+      for (int i = 0; i < dims[d]; i++) {
+         plain.vector[i] = HVECTOR(&fvector)[i];
+         total += 2.0 * plain.vector[i];
+      }
+      hvector_t converted = vectors_hvector(&plain);
+
+      vectors_hadd(&result, &fvector, &svector);
+      vectors_hsubtract(&result, &result, &svector);
+      bool_t passed = vectors_hisequal(&result, &fvector) &&
+                      vectors_hisequal(&converted, &fvector);
+
+      vectors_hscaler_mul(&result, &svector, 0.5);
+      passed = passed && vectors_hisarbitrary(&result, 1.0) &&
+               vectors_hdot_mul(&fvector, &svector) == total &&
+               fabs(vectors_hlenght(&svector) - 2.0 * sqrt(dims[d])) < 1e-15;
+
+      // The copy must own its elements after the original is changed.
+      HVECTOR(&fvector)[0] = -1.0;
+      passed = passed && HVECTOR(&copy)[0] == 1.0;
+
+      check(passed, (dims[d] == 3) ? "inline handle vector" :
+                                     "heap handle vector");
+      vectors_hfree(&fvector), vectors_hfree(&svector);
+      vectors_hfree(&result), vectors_hfree(&copy), vectors_hfree(&converted);
+   }
+
+   hvector_t xaxis = vectors_harray((double []) {2, 0, 0}, 3);
+   hvector_t yaxis = vectors_harray((double []) {0, 3, 0}, 3);
+   hvector_t zaxis = vectors_hzeros(3);
+   hvector_t unit = vectors_hzeros(3);
+
+   vectors_hcross_mul(&zaxis, &xaxis, &yaxis);
+   vectors_hunit(&unit, &zaxis);
+   check(HVECTOR(&zaxis)[2] == 6.0 && HVECTOR(&unit)[2] == 1.0 &&
+         fabs(vectors_hangle(&xaxis, &yaxis, "degrees") - 90.0) < 1e-13 &&
+         vectors_hdistance(&xaxis, &yaxis) == sqrt(13.0),
+         "handle cross, unit, angle, distance");
+
+   // Small vectors must match the plain three-dimensional operations.
+   vec3_t fvec = vectors_vec3(1, 2, 3), svec = vectors_vec3(-2, 0.5, 4);
+   vec3_t cross = vectors_vec_cross(fvec, svec);
+
+   check(vectors_vec_dot(fvec, svec) == 11.0 &&
+         cross.xy[0] == 6.5 && cross.xy[1] == -10.0 && cross.zw[0] == 4.5 &&
+         vectors_vec_dot(cross, fvec) == 0.0 &&
+         fabs(vectors_vec_lenght(vectors_vec_unit(svec)) - 1.0) < 1e-15 &&
+         fabs(vectors_vec_angle(fvec, fvec)) < 1e-7,
+         "small vector operations");
+
+   vec4_t fvecs[5], svecs[5], units[5];
+   vec3_t crosses[5];
+   double dots[5];
+   bool_t batched = true;
+
+   for (int i = 0; i < 5; i++)
+      fvecs[i] = vectors_vec3(i, 1, -i), svecs[i] = vectors_vec3(2, i, 1);
+   vectors_vec_dot_batch(dots, fvecs, svecs, 5);
+   vectors_vec_cross_batch(crosses, fvecs, svecs, 5);
+   vectors_vec_unit_batch(units, svecs, 5);
+   for (int i = 0; i < 5; i++) {
+      vec3_t expected = vectors_vec_cross(fvecs[i], svecs[i]);
+      batched = batched && dots[i] == vectors_vec_dot(fvecs[i], svecs[i]) &&
+                crosses[i].xy[0] == expected.xy[0] &&
+                crosses[i].zw[0] == expected.zw[0] &&
+                fabs(vectors_vec_lenght(units[i]) - 1.0) < 1e-15;
+   }
+   check(batched, "small vector batches");
+
+   // Array operations must match the naive loops.
+   size_t n = 1003;
+   double *x = malloc(sizeof(double) * n), *y = malloc(sizeof(double) * n);
+   double *z = malloc(sizeof(double) * n);
+   double dot = 0.0, norm = 0.0, fused, xnorm, ynorm;
+
+   for (size_t i = 0; i < n; i++) {
+      x[i] = sin(i * 0.3), y[i] = z[i] = cos(i * 0.7);
+      dot += x[i] * y[i], norm += x[i] * x[i];
+   }
+   vectors_dot_nrm2(n, x, y, &fused, &xnorm, &ynorm);
+   bool_t blas = fabs(vectors_dot(n, x, y) - dot) < 1e-12 &&
+                 fabs(vectors_nrm2(n, x) - sqrt(norm)) < 1e-12 &&
+                 fabs(vectors_sqdist(n, x, x)) == 0.0 &&
+                 fabs(fused - dot) < 1e-12 &&
+                 fabs(xnorm - sqrt(norm)) < 1e-12;
+
+   vectors_axpby(n, 2.0, x, -1.0, y);
+   vectors_axpy(n, 1.0, z, y);
+   vectors_scal(n, 0.5, y);
+   for (size_t i = 0; i < n; i++)
+      blas = blas && fabs(y[i] - x[i]) < 1e-15;
+   check(blas, "dot, nrm2, sqdist, axpby, axpy, scal");
+
+   // Pairwise tiles must match the distances of each pair.
+   size_t fcount = 70, scount = 67;
+   dim_t dim = 150;
+   double *fset = malloc(sizeof(double) * fcount * dim);
+   double *sset = malloc(sizeof(double) * scount * dim);
+   double *distances = malloc(sizeof(double) * fcount * scount);
+   double *similars = malloc(sizeof(double) * fcount * scount);
+   double error = 0.0;
+
+   for (size_t i = 0; i < fcount * dim; i++)
+      fset[i] = sin(i * 0.017) + (i % 7) * 0.1;
+   for (size_t i = 0; i < scount * dim; i++)
+      sset[i] = cos(i * 0.023) - (i % 5) * 0.1;
+
+   vectors_pairwise(distances, fset, fcount, sset, scount, dim,
+                    METRIC_EUCLIDEAN, true);
+   vectors_pairwise(similars, fset, fcount, sset, scount, dim,
+                    METRIC_COSINE, false);
+   for (size_t i = 0; i < fcount; i++) {
+      for (size_t j = 0; j < scount; j++) {
+         const double *a = fset + i * dim, *b = sset + j * dim;
+         double cosine = vectors_dot(dim, a, b) /
+                         (vectors_nrm2(dim, a) * vectors_nrm2(dim, b));
+
+         error = fmax(error, fabs(distances[i*scount+j] -
+                                  sqrt(sqdist(a, b, dim))));
+         error = fmax(error, fabs(similars[i*scount+j] - cosine));
+      }
+   }
+   check(error < 1e-12, "pairwise");
+
+   // Each vector is the most similar one to itself, also when quantized.
+   double *items = malloc(sizeof(double) * scount * dim);
+
+   for (size_t i = 0; i < scount * dim; i++)
+      items[i] = sin(i * 12.9898) * 43758.5453 -
+                 floor(sin(i * 12.9898) * 43758.5453) - 0.5;
+
+   for (int q = 0; q < 2; q++) {
+      simindex_t *index = vectors_simindex(items, scount, dim, q);
+      size_t indices[3 * 67];
+      double scores[3 * 67];
+      bool_t found = true;
+
+      vectors_simindex_search(index, indices, scores, items, scount, 3);
+      for (size_t i = 0; i < scount; i++)
+         found = found && indices[3*i] == i && scores[3*i] > 0.99 &&
+                 scores[3*i] >= scores[3*i+1] &&
+                 scores[3*i+1] >= scores[3*i+2];
+      check(found, q ? "quantized simindex search" : "simindex search");
+      vectors_simindex_free(index);
+   }
+
+   // Tree queries must match brute force over all points.
+   size_t count = 2000, found, total, k = 4;
+   double *points = malloc(sizeof(double) * count * 3);
+   size_t *indices = malloc(sizeof(size_t) * count);
+   double query[3] = {0.1, -0.2, 0.3}, lower[3] = {-0.5, -0.5, 0.0};
+   double upper[3] = {0.0, 0.5, 0.5}, nearest[4];
+   size_t knn[4];
+
+   for (size_t i = 0; i < count * 3; i++)
+      points[i] = sin(i * 12.9898) * 0.5 + cos(i * 78.233) * 0.5;
+
+   kdtree_t *tree = vectors_kdtree(points, count, 3);
+   vectors_kdtree_knn(tree, knn, nearest, query, 1, k);
+
+   bool_t brute = true;
+   for (size_t j = 0; j < k; j++) {
+      double bound = sqrt(sqdist(points + knn[j] * 3, query, 3));
+      size_t closer = 0;
+
+      for (size_t i = 0; i < count; i++)
+         closer += sqrt(sqdist(points + i * 3, query, 3)) < bound;
+      brute = brute && closer == j && fabs(nearest[j] - bound) < 1e-15;
+   }
+   check(brute, "kdtree knn vs brute force");
+
+   found = vectors_kdtree_radius(tree, indices, count, query, 0.4);
+   total = 0;
+   for (size_t i = 0; i < count; i++)
+      total += sqdist(points + i * 3, query, 3) <= 0.16;
+   brute = (found == total);
+   for (size_t i = 0; i < found; i++)
+      brute = brute && sqdist(points + indices[i] * 3, query, 3) <= 0.16;
+   check(brute && total > 0, "kdtree radius vs brute force");
+
+   found = vectors_kdtree_box(tree, indices, count, lower, upper);
+   total = 0;
+   for (size_t i = 0; i < count; i++) {
+      bool_t inside = true;
+      for (int j = 0; j < 3; j++)
+         inside = inside && points[i*3+j] >= lower[j] &&
+                  points[i*3+j] <= upper[j];
+      total += inside;
+   }
+   check(found == total && total > 0, "kdtree box vs brute force");
+   vectors_kdtree_free(tree);
+
+   // Batches of coordinates must match the single transform and come back.
+   double rx[4], ry[4], rz[4], bx[4], by[4], bz[4];
+   double px[4] = {1, -2, 0.5, 3}, py[4] = {2, 1, -0.5, 0};
+   double pz[4] = {3, -1, 2, -4};
+   vector_t point = {.dim = 3, .vector = {px[1], py[1], pz[1]}};
+   vector_t single = vectors_transform(point, "cartesian", "spherical");
+
+   vectors_transform_batch(rx, ry, rz, px, py, pz, 4, COOR_CARTESIAN,
+                           COOR_SPHERICAL);
+   vectors_transform_batch(bx, by, bz, rx, ry, rz, 4, COOR_SPHERICAL,
+                           COOR_CYLINDRICAL);
+   vectors_transform_batch(bx, by, bz, bx, by, bz, 4, COOR_CYLINDRICAL,
+                           COOR_CARTESIAN);
+
+   bool_t transformed = fabs(rx[1] - single.vector[0]) < 1e-14 &&
+                        fabs(ry[1] - single.vector[1]) < 1e-12 &&
+                        fabs(rz[1] - single.vector[2]) < 1e-12;
+   for (int i = 0; i < 4; i++)
+      transformed = transformed && fabs(bx[i] - px[i]) < 1e-14 &&
+                    fabs(by[i] - py[i]) < 1e-14 && fabs(bz[i] - pz[i]) < 1e-14;
+   check(transformed, "transform batch");
+
+   // Rotating (1, 0, 0) by 90 degrees around z, scaling by 2 and moving it
+   // gives (1, 2, 3).
+   xform_t xform = vectors_xform_compose(
+      vectors_xform_compose(vectors_xform_rotate(vectors_vec3(0, 0, 1), 90),
+                            vectors_xform_scale(2, 2, 2)),
+      vectors_xform_translate(1, 0, 3));
+   double ox = 1, oy = 0, oz = 0;
+
+   vectors_xform_apply(&xform, &ox, &oy, &oz, &ox, &oy, &oz, 1);
+   bool_t applied = fabs(ox - 1) < 1e-15 && fabs(oy - 2) < 1e-15 &&
+                    fabs(oz - 3) < 1e-15;
+
+   // Identity and transforms from matrices leave or project points.
+   matrix_t projection = {
+      .shape = {4, 4},
+      .matrix = {
+         {1, 0, 0, 0},
+         {0, 1, 0, 0},
+         {0, 0, 1, 0},
+         {0, 0, 1, 0}
+      }
+   };
+   xform = vectors_xform_identity();
+   vectors_xform_apply(&xform, &ox, &oy, &oz, &ox, &oy, &oz, 1);
+   xform = vectors_xform_matrix(projection);
+   vectors_xform_apply(&xform, &ox, &oy, &oz, &ox, &oy, &oz, 1);
+   applied = applied && ox == 1.0 / 3 && oy == 2.0 / 3 && oz == 1.0;
+   check(applied, "xform compose and apply");
+
+   exit(failures ? EXIT_FAILURE : EXIT_SUCCESS);
+}
@@ -12,15 +12,29 @@
 #include <unistd.h>
 #include <math.h>
 #include <time.h>
+#include <float.h>
+#include <stdint.h>
+#include <limits.h>
 
 /* Global constants */
 
 #define ROW       64
 #define COL       64
 #define LEN       ROW * COL
+#define HLEN      4
  
 #define DEG(rad)              (rad * 180.0 / M_PI)
 #define RAD(deg)              (deg * M_PI / 180.0)
+#define HVECTOR(hvec)         ((hvec)->dim <= HLEN ? (hvec)->store.local : \
+                                                     (hvec)->store.heap)
+
+/* Kernels marked with ALAT_SIMD are compiled for AVX-512, AVX2 and base
+   x86-64, and the best one is selected at run time. */
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__)
+#define ALAT_SIMD   __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define ALAT_SIMD
+#endif
 
 #define alat_error(err_msg)   do {                                        \
    fprintf(stderr, "*** %s (%s::%d) ***\n", err_msg, __FILE__, __LINE__); \
@@ -43,6 +57,34 @@ typedef enum {
    false, 
    true, 
 } bool_t;
+
+typedef enum {
+   METRIC_EUCLIDEAN,          // Euclidean distance
+   METRIC_SQEUCLIDEAN,        // Squared euclidean distance
+   METRIC_COSINE,             // Cosine similarity
+} metric_t;
+
+typedef enum {
+   MATH_STRICT,               // libm for each element
+   MATH_FAST,                 // Vectorized kernels, accurate to a few ulp
+} mathmode_t;
+
+typedef enum {
+   COOR_CARTESIAN,            // (x, y, z)
+   COOR_CYLINDRICAL,          // (rho, phi, z), phi in degrees
+   COOR_SPHERICAL,            // (r, theta, phi), angles in degrees
+} coor_t;
+
+typedef enum {
+   SPLINE_NATURAL,            // Second derivatives are zero at ends
+   SPLINE_CLAMPED,            // First derivatives are given at ends
+   SPLINE_NOTAKNOT,           // Third derivatives are continuous at ends
+} splineend_t;
+
+typedef enum {
+   FORM_CARTESIAN,            // Complex number as real and imaginary
+   FORM_POLAR,                // Complex number as modules and argument
+} form_t;
  
 /* User-deined stuctures */
 
@@ -61,11 +103,115 @@ typedef struct {
    vec_t vector[LEN];          // Vector itself
 } vector_t;
 
+typedef vec_t vec2d_t __attribute__((vector_size(2 * sizeof(vec_t))));
+
+typedef struct {
+   vec2d_t xy;                 // x and y elements of vector
+   vec2d_t zw;                 // z and w elements of vector
+} vec4_t;
+
+typedef vec4_t vec3_t;         // Three-dimensional vector (w is zero)
+
+typedef struct {
+   double m[4][4];             // Row-major homogeneous transform matrix
+} xform_t;
+
+typedef struct {
+   dim_t dim;                  // Dimension of vector
+   union {
+      vec_t local[HLEN];       // Elements of small vector
+      vec_t *heap;             // Elements of large vector
+   } store;                    // Use HVECTOR to access elements
+} hvector_t;                   // Move-only, duplicate with vectors_hcopy
+
 typedef struct {
    str_t form;                 // Form of complex number (cartesian or polar)
    com_t complex[2];           // Complex number itself
 } complex_t;
 
+typedef struct {
+   com_t re;                   // Real portion of complex value
+   com_t im;                   // Imaginary portion of complex value
+} cnum_t;
+
+typedef struct {
+   matrix_t re;                // Real portion of complex matrix
+   matrix_t im;                // Imaginary portion of complex matrix
+} cmatrix_t;
+
+typedef struct {
+   size_t size;                // Count of complex values
+   com_t *re;                  // Real portions of complex values
+   com_t *im;                  // Imaginary portions of complex values
+} carray_t;
+
+typedef struct fftplan {
+   size_t size;                // Length of transform
+   bool_t real;                // Whether transform is real-input
+   bool_t odd;                 // Whether count of radix-2 stages is odd
+   size_t scratch;             // Count of scratch elements for transform
+   size_t *bitrev;             // Bit reversal order (powers of two)
+   com_t *twre, *twim;         // Twiddle factors of radix-4 passes
+   com_t *tw2re, *tw2im;       // Twiddle factors of inner radix-2 stages
+   carray_t chirp;             // Bluestein chirp or real split factors
+   carray_t filter;            // Transformed Bluestein filter
+   carray_t work;              // Scratch elements of plan
+   struct fftplan *inner;      // Inner power-of-two or half-length plan
+} fftplan_t;
+
+typedef struct {
+   size_t count;               // Count of indexed vectors
+   dim_t dim;                  // Dimension of vectors
+   bool_t quantized;           // Whether vectors are stored as int8
+   double *vectors;            // Normalized vectors (or NULL)
+   int8_t *codes;              // Quantized normalized vectors (or NULL)
+   double *scales;             // Scales of quantized vectors (or NULL)
+} simindex_t;
+
+typedef struct {
+   size_t count;               // Count of points
+   dim_t dim;                  // Dimension of points (2 or 3)
+   double *points;             // Points in order of tree
+   size_t *order;              // Positions of points in original array
+   unsigned char *axes;        // Split axes of nodes by median position
+} kdtree_t;
+
+typedef struct {
+   size_t count;               // Count of knots
+   int steps;                  // Count of search steps in each cell
+   int *cells;                 // First intervals of equal cells of knots
+   double *knots;              // x axis points of knots
+   double *coefs;              // Coefficients of (x - knot) powers in turn
+} spline_t;
+
+typedef struct {
+   dim_t features;             // Count of features of each point
+   dim_t degree;               // Highest power of each feature
+   dim_t terms;                // Count of coefficients (1 + features * degree)
+   double weight;              // Sum of weights of points
+   double yty;                 // Weighted sum of squared targets
+   double *xtx;                // Weighted X^T X (upper triangle is used)
+   double *xty;                // Weighted X^T y
+} lsq_t;
+
+typedef struct {
+   dim_t dim;                             // Block size of key
+   double det;                            // Determinant (0 if modular)
+   matrix_t encoder;                      // Validated encoder
+   matrix_t decoder;                      // Inverse (zeros if modular)
+   unsigned int modulus;                  // Modulus of arithmetic (or 0)
+   unsigned short modencoder[ROW][COL];   // Encoder reduced in modulo
+   unsigned short moddecoder[ROW][COL];   // Modular inverse of encoder
+} crypts_key_t;
+
+typedef struct {
+   const crypts_key_t *key;            // Key of stream
+   bool_t decode;                      // Direction of stream
+   int threads;                        // Count of threads for batches
+   unsigned char buffer[COL];          // Bytes of incomplete block
+   size_t pending;                     // Count of bytes in buffer
+} crypts_stream_t;
+
 /* Matrix methods */
 
 bool_t matrices_issquare(matrix_t matrix);                       
@@ -80,6 +226,7 @@ bool_t matrices_isdiagonal(matrix_t matrix);
 bool_t matrices_issymmetric(matrix_t matrix);
 bool_t matrices_isequal(matrix_t fmatrix, matrix_t smatrix);     
 bool_t matrices_istriangle(matrix_t matrix);                     
+bool_t matrices_isinteger(matrix_t matrix);
 bool_t matrices_isinvertible(matrix_t matrix);                   
 matrix_t matrices_zeros(shape_t shape);                          
 matrix_t matrices_ones(shape_t shape);                           
@@ -117,11 +264,21 @@ matrix_t matrices_scaler_div(matrix_t matrix, double scaler);
 matrix_t matrices_swap(matrix_t matrix);                                
 matrix_t matrices_dot_div(matrix_t fmatrix, matrix_t smatrix);          
 double matrices_det(matrix_t matrix);
+int matrices_rank(matrix_t matrix);
 matrix_t matrices_minors(matrix_t matrix);
 matrix_t matrices_cofactors(matrix_t matrix);
 matrix_t matrices_adjoint(matrix_t matrix);
 matrix_t matrices_inverse(matrix_t matrix);
 matrix_t matrices_solve(matrix_t matrix);  
+matrix_t matrices_matpow(matrix_t matrix, long n);
+matrix_t matrices_expm(matrix_t matrix);
+matrix_t matrices_multi_mul(int n, const matrix_t *mats, double *flops);
+cmatrix_t matrices_complex(matrix_t real, matrix_t imaginary);
+cmatrix_t matrices_complex_add(cmatrix_t fmatrix, cmatrix_t smatrix);
+cmatrix_t matrices_complex_subtract(cmatrix_t fmatrix, cmatrix_t smatrix);
+cmatrix_t matrices_complex_cross_mul(cmatrix_t fmatrix, cmatrix_t smatrix);
+cmatrix_t matrices_complex_conj_transpose(cmatrix_t matrix);
+cmatrix_t matrices_complex_solve(cmatrix_t matrix);
 
 /* Vector methods */
 
@@ -142,6 +299,19 @@ vector_t vectors_random(dim_t dim);
 vector_t vectors_uniform(int start, int end, dim_t dim);
 vector_t vectors_randint(int start, int end, dim_t dim);
 vector_t vectors_transform(vector_t vector, str_t old_coor, str_t new_coor);
+void vectors_transform_batch(double *rx, double *ry, double *rz, 
+                             const double *x, const double *y, 
+                             const double *z, size_t count, coor_t old_coor,
+                             coor_t new_coor);
+xform_t vectors_xform_identity(void);
+xform_t vectors_xform_translate(double tx, double ty, double tz);
+xform_t vectors_xform_scale(double sx, double sy, double sz);
+xform_t vectors_xform_rotate(vec3_t axis, double angle);
+xform_t vectors_xform_matrix(matrix_t matrix);
+xform_t vectors_xform_compose(xform_t first, xform_t second);
+void vectors_xform_apply(const xform_t *xform, double *rx, double *ry, 
+                         double *rz, const double *x, const double *y,
+                         const double *z, size_t count);
 double vectors_lenght(vector_t vector);
 vector_t vectors_abs(vector_t vector);
 vector_t vectors_pow(vector_t vector, double n);
@@ -154,6 +324,316 @@ double vectors_distance(vector_t fvector, vector_t svector);
 double vectors_dot_mul(vector_t fvector, vector_t svector);
 vector_t vectors_cross_mul(vector_t fvector, vector_t svector);
 double vectors_angle(vector_t fvector, vector_t svector, str_t form);
+hvector_t vectors_hzeros(dim_t dim);
+hvector_t vectors_hones(dim_t dim);
+hvector_t vectors_harbitrary(double value, dim_t dim);
+hvector_t vectors_hsequential(int start, int end, dim_t dim);
+hvector_t vectors_harray(const double *array, dim_t lenght);
+hvector_t vectors_hvector(const vector_t *vector);
+hvector_t vectors_hcopy(const hvector_t *vector);
+void vectors_hfree(hvector_t *vector);
+bool_t vectors_hisarbitrary(const hvector_t *vector, double value);
+bool_t vectors_hisequal(const hvector_t *fvector, const hvector_t *svector);
+double vectors_hlenght(const hvector_t *vector);
+void vectors_habs(hvector_t *result, const hvector_t *vector);
+void vectors_hpow(hvector_t *result, const hvector_t *vector, double n);
+void vectors_hroot(hvector_t *result, const hvector_t *vector, double n);
+void vectors_hunit(hvector_t *result, const hvector_t *vector);
+void vectors_hadd(hvector_t *result, const hvector_t *fvector, 
+                  const hvector_t *svector);
+void vectors_hsubtract(hvector_t *result, const hvector_t *fvector, 
+                       const hvector_t *svector);
+void vectors_hscaler_mul(hvector_t *result, const hvector_t *vector, 
+                         double scaler);
+double vectors_hdistance(const hvector_t *fvector, const hvector_t *svector);
+double vectors_hdot_mul(const hvector_t *fvector, const hvector_t *svector);
+void vectors_hcross_mul(hvector_t *result, const hvector_t *fvector,
+                        const hvector_t *svector);
+double vectors_hangle(const hvector_t *fvector, const hvector_t *svector, 
+                      str_t form);
+
+void vectors_axpy(size_t n, double alpha, const double *x, double *y);
+void vectors_axpby(size_t n, double alpha, const double *x, double beta,
+                   double *y);
+void vectors_scal(size_t n, double alpha, double *x);
+double vectors_dot(size_t n, const double *x, const double *y);
+double vectors_sqdist(size_t n, const double *x, const double *y);
+double vectors_nrm2(size_t n, const double *x);
+void vectors_dot_nrm2(size_t n, const double *x, const double *y, 
+                      double *dot, double *xnorm, double *ynorm);
+void vectors_pairwise(double *result, const double *fset, size_t fcount,
+                      const double *sset, size_t scount, dim_t dim,
+                      metric_t metric, bool_t exact);
+simindex_t *vectors_simindex(const double *set, size_t count, dim_t dim,
+                             bool_t quantize);
+void vectors_simindex_free(simindex_t *index);
+void vectors_simindex_search(const simindex_t *index, size_t *indices,
+                             double *scores, const double *queries,
+                             size_t qcount, size_t k);
+kdtree_t *vectors_kdtree(const double *points, size_t count, dim_t dim);
+void vectors_kdtree_free(kdtree_t *tree);
+void vectors_kdtree_knn(const kdtree_t *tree, size_t *indices, 
+                        double *distances, const double *queries, 
+                        size_t qcount, size_t k);
+size_t vectors_kdtree_radius(const kdtree_t *tree, size_t *indices, 
+                             size_t capacity, const double *query, 
+                             double radius);
+size_t vectors_kdtree_box(const kdtree_t *tree, size_t *indices, 
+                          size_t capacity, const double *lower, 
+                          const double *upper);
+void vectors_vec_dot_batch(double *result, const vec4_t *fvecs, 
+                           const vec4_t *svecs, size_t count);
+void vectors_vec_cross_batch(vec3_t *result, const vec3_t *fvecs, 
+                             const vec3_t *svecs, size_t count);
+void vectors_vec_unit_batch(vec4_t *result, const vec4_t *vecs, size_t count);
+
+/* Small vector methods (each lane pair is one SSE register) */
+
+static inline vec3_t vectors_vec3(double x, double y, double z)
+{
+   return (vec3_t) {{x, y}, {z, 0.0}};
+}
+
+static inline vec4_t vectors_vec4(double x, double y, double z, double w)
+{
+   return (vec4_t) {{x, y}, {z, w}};
+}
+
+static inline vec4_t vectors_vec_add(vec4_t fvec, vec4_t svec)
+{
+   return (vec4_t) {fvec.xy + svec.xy, fvec.zw + svec.zw};
+}
+
+static inline vec4_t vectors_vec_subtract(vec4_t fvec, vec4_t svec)
+{
+   return (vec4_t) {fvec.xy - svec.xy, fvec.zw - svec.zw};
+}
+
+static inline vec4_t vectors_vec_scaler_mul(vec4_t vec, double scaler)
+{
+   return (vec4_t) {vec.xy * scaler, vec.zw * scaler};
+}
+
+static inline double vectors_vec_dot(vec4_t fvec, vec4_t svec)
+{
+   vec2d_t sum = fvec.xy * svec.xy + fvec.zw * svec.zw;
+
+   return sum[0] + sum[1];
+}
+
+static inline vec3_t vectors_vec_cross(vec3_t fvec, vec3_t svec)
+{
+   return vectors_vec3(fvec.xy[1] * svec.zw[0] - fvec.zw[0] * svec.xy[1],
+                       fvec.zw[0] * svec.xy[0] - fvec.xy[0] * svec.zw[0],
+                       fvec.xy[0] * svec.xy[1] - fvec.xy[1] * svec.xy[0]);
+}
+
+static inline double vectors_vec_lenght(vec4_t vec)
+{
+   return sqrt(vectors_vec_dot(vec, vec));
+}
+
+static inline vec4_t vectors_vec_unit(vec4_t vec)
+{
+   return vectors_vec_scaler_mul(vec, 1.0 / vectors_vec_lenght(vec));
+}
+
+static inline vec4_t vectors_vec_lerp(vec4_t fvec, vec4_t svec, double t)
+{
+   return (vec4_t) {fvec.xy + (svec.xy - fvec.xy) * t, 
+                    fvec.zw + (svec.zw - fvec.zw) * t};
+}
+
+static inline double vectors_vec_angle(vec4_t fvec, vec4_t svec)
+{
+   double angle = vectors_vec_dot(fvec, svec) / 
+      sqrt(vectors_vec_dot(fvec, fvec) * vectors_vec_dot(svec, svec));
+
+   return acos((angle > 1.0) ? 1.0 : (angle < -1.0) ? -1.0 : angle);
+}
+
+/* Elementwise math kernels of fast mode (branchless, so loops over them are
+   vectorized). Measured against long double references, sine and cosine 
+   are accurate to 2 ulp for angles within 2^50 degrees, atan2 to 3 ulp for
+   finite arguments, exp to 2 ulp, log and cbrt to 1 ulp. */
+
+#define ALAT_ROUND(x)   (((x) + 6755399441055744.0) - 6755399441055744.0)
+
+/**
+ * Calculate sine and cosine of `deg` in degrees together. Reduction by
+ * right angles is exact, so sine of 180 degrees is exactly zero. If 
+ * `strict` is true, reduced angle is passed to libm instead of polynomials.
+ */
+static inline void alat_sincosd(double deg, double *sine, double *cosine,
+                                bool_t strict)
+{
+   double q, quad, r, z, s, c;
+
+   q = ALAT_ROUND(deg / 90.0);
+   quad = q - 4.0 * ALAT_ROUND(q * 0.25);
+   quad = (quad < 0.0) ? quad + 4.0 : quad;
+   r = (deg - 90.0 * q) * (M_PI / 180.0);
+   z = r * r;
+
+   if (strict) {
+      s = sin(r), c = cos(r);
+   }
+   else {
+      // Minimax polynomials in [-pi/4, pi/4] (Cephes).
+      s = r + r * z * (((((1.58962301576546568060e-10 * z - 
+          2.50507477628578072866e-8) * z + 2.75573136213857245213e-6) * z - 
+          1.98412698295895385996e-4) * z + 8.33333333332211858878e-3) * z - 
+          1.66666666666666307295e-1);
+      c = 1.0 - 0.5 * z + z * z * (((((-1.13585365213876817300e-11 * z + 
+          2.08757008419747316778e-9) * z - 2.75573141792967388112e-7) * z + 
+          2.48015872888517045348e-5) * z - 1.38888888888730564116e-3) * z + 
+          4.16666666666665929218e-2);
+   }
+
+   *sine = (quad == 0.0) ? s : (quad == 1.0) ? c : (quad == 2.0) ? -s : -c;
+   *cosine = (quad == 0.0) ? c : (quad == 1.0) ? -s : (quad == 2.0) ? -c : s;
+}
+
+/**
+ * Calculate the angle of (`x`, `y`) point in radians in [-pi, pi]. Signed
+ * zeros give the same quadrants as `atan2`.
+ */
+static inline double alat_atan2(double y, double x)
+{
+   double ax = fabs(x), ay = fabs(y), num, den, t, u, z, r, base;
+   int swap = (ay > ax), big;
+
+   // Reduce to atan(t) where t is in [0, tan(pi/8)]. Both divisions are 
+   // always done, so there is no branch in the loops.
+   num = swap ? ax : ay, den = swap ? ay : ax;
+   t = num / ((den == 0.0) ? 1.0 : den);
+   u = (t - 1.0) / (t + 1.0);
+   big = (t > 0.41421356237309504880);
+   base = big ? M_PI_4 : 0.0;
+   t = big ? u : t;
+   z = t * t;
+
+   // Rational approximation of atan (Cephes).
+   r = z * ((((-8.750608600031904122785e-1 * z - 
+       1.615753718733365076637e1) * z - 7.500855792314704667340e1) * z - 
+       1.228866684490136173410e2) * z - 6.485021904942025371773e1) / 
+       (((((z + 2.485846490142306297962e1) * z + 
+       1.650270098316988542046e2) * z + 4.328810604912902668951e2) * z + 
+       4.853903996359136964868e2) * z + 1.945506571482613964425e2);
+   r = base + (t + t * r);
+
+   r = swap ? M_PI_2 - r : r;
+   r = signbit(x) ? M_PI - r : r;
+   return copysign(r, y);
+}
+
+/**
+ * Calculate the exponential of `x` + `low`, where `low` is a small tail 
+ * below the precision of `x` (such as error term of double-double). 
+ * Results below DBL_MIN are subnormal, and results beyond DBL_MAX are 
+ * infinite.
+ */
+static inline double alat_expdd(double x, double low)
+{
+   double n, half, r, rr, p, e, fscale, sscale;
+   uint64_t fbits, sbits;
+
+   x = (x > 710.0) ? 710.0 : (x < -746.0) ? -746.0 : x;
+
+   // Reduce to exp(r) * 2^n where r is in [-ln(2)/2, ln(2)/2].
+   n = ALAT_ROUND(x * M_LOG2E);
+   r = ((x - n * 6.93145751953125e-1) - n * 1.42860682030941723212e-6) + 
+       low;
+   rr = r * r;
+
+   // Rational approximation of exp (Cephes).
+   p = r * ((1.26177193074810590878e-4 * rr + 3.02994407707441961300e-2) * 
+       rr + 9.99999999999999999910e-1);
+   e = 1.0 + 2.0 * p / ((((3.00198505138664455042e-6 * rr + 
+       2.52448340349684104192e-3) * rr + 2.27265548208155028766e-1) * rr +
+       2.0) - p);
+
+   // Scale by 2^n in two halves, so subnormal results are not lost. Adding
+   // 2^52 puts the biased exponent into low bits of mantissa.
+   half = ALAT_ROUND(n * 0.5);
+   fscale = half + (1023.0 + 4503599627370496.0);
+   sscale = (n - half) + (1023.0 + 4503599627370496.0);
+   memcpy(&fbits, &fscale, sizeof(double));
+   memcpy(&sbits, &sscale, sizeof(double));
+   fbits <<= 52, sbits <<= 52;
+   memcpy(&fscale, &fbits, sizeof(double));
+   memcpy(&sscale, &sbits, sizeof(double));
+
+   return e * fscale * sscale;
+}
+
+/**
+ * Calculate the exponential of `x`.
+ */
+static inline double alat_exp(double x)
+{
+   return alat_expdd(x, 0.0);
+}
+
+/**
+ * Calculate the natural logarithm of `x`.
+ */
+static inline double alat_log(double x)
+{
+   double m, e, f, z, r, tiny;
+   uint64_t bits, ebits;
+
+   // Scale subnormals up, so their exponents are in exponent field.
+   tiny = (x < DBL_MIN) ? 54.0 : 0.0;
+   m = (x < DBL_MIN) ? x * 18014398509481984.0 : x;
+
+   // Split x into m * 2^e where m is in [1, 2).
+   memcpy(&bits, &m, sizeof(double));
+   ebits = (bits >> 52) | 0x4330000000000000;
+   bits = (bits & 0x000FFFFFFFFFFFFF) | 0x3FF0000000000000;
+   memcpy(&e, &ebits, sizeof(double));
+   memcpy(&m, &bits, sizeof(double));
+   e = e - (4503599627370496.0 + 1023.0) - tiny;
+
+   // Move m into [sqrt(1/2), sqrt(2)), and calculate log(1 + f).
+   e = (m > M_SQRT2) ? e + 1.0 : e;
+   f = (m > M_SQRT2) ? 0.5 * m - 1.0 : m - 1.0;
+   z = f * f;
+
+   // Rational approximation of log(1 + f) (Cephes).
+   r = f * (z * (((((1.01875663804580931796e-4 * f + 
+       4.97494994976747001425e-1) * f + 4.70579119878881725854e0) * f + 
+       1.44989225341610930846e1) * f + 1.79368678507819816313e1) * f + 
+       7.70838733755885391666e0) / (((((f + 1.12873587189167450590e1) * f +
+       4.52279145837532221105e1) * f + 8.29875266912776603211e1) * f + 
+       7.11544750618563894466e1) * f + 2.31251620126765340583e1));
+   r = r - e * 2.121944400546905827679e-4 - 0.5 * z;
+   r = (f + r) + e * 0.693359375;
+
+   r = (x == INFINITY) ? x : r;
+   r = (x == 0.0) ? -INFINITY : r;
+   r = (x < 0.0) ? NAN : r;
+   return (x != x) ? x : r;
+}
+
+/**
+ * Calculate the cube root of `x`, which keeps the sign of `x`.
+ */
+static inline double alat_cbrt(double x)
+{
+   double a = fabs(x), m, y;
+
+   // Subnormals are scaled by 2^54, so the cube in Newton step is normal.
+   m = (a < DBL_MIN) ? a * 18014398509481984.0 : a;
+
+   // Newton step on exp(log(m) / 3) removes most of its error.
+   y = alat_exp(alat_log(m) * (1.0 / 3.0));
+   y = y - (y * y * y - m) / (3.0 * y * y);
+   y = (a < DBL_MIN) ? y * 0x1p-18 : y;
+
+   y = (a == 0.0 || a == INFINITY) ? a : y;
+   return copysign(y, x);
+}
 
 /* Complex number methods */
 
@@ -176,6 +656,46 @@ complex_t complexes_power(complex_t complex, double n, str_t output_form);
 complex_t complexes_root(complex_t complex, double n, str_t output_form);
 complex_t complexes_conjugate(complex_t complex, str_t output_form);
 complex_t complexes_reciprocol(complex_t complex, str_t output_form);
+cnum_t complexes_cnum(double real, double imaginary);
+cnum_t complexes_cnum_polar(double modules, double argument);
+cnum_t complexes_to_cnum(complex_t complex);
+complex_t complexes_from_cnum(cnum_t z, form_t form);
+double complexes_cabs(cnum_t z);
+double complexes_carg(cnum_t z);
+cnum_t complexes_cadd(cnum_t fz, cnum_t sz);
+cnum_t complexes_csub(cnum_t fz, cnum_t sz);
+cnum_t complexes_cmul(cnum_t fz, cnum_t sz);
+cnum_t complexes_cdiv(cnum_t fz, cnum_t sz);
+cnum_t complexes_cconj(cnum_t z);
+cnum_t complexes_crecip(cnum_t z);
+cnum_t complexes_cpowi(cnum_t z, int n);
+cnum_t complexes_cpow(cnum_t z, double n);
+cnum_t complexes_croot(cnum_t z, double n);
+void complexes_croots(cnum_t z, int n, cnum_t roots[]);
+carray_t complexes_carray(size_t size);
+void complexes_carray_free(carray_t *array);
+void complexes_carray_add(carray_t *result, const carray_t *farray, 
+                          const carray_t *sarray);
+void complexes_carray_subtract(carray_t *result, const carray_t *farray, 
+                               const carray_t *sarray);
+void complexes_carray_multiply(carray_t *result, const carray_t *farray, 
+                               const carray_t *sarray);
+void complexes_carray_divide(carray_t *result, const carray_t *farray, 
+                             const carray_t *sarray);
+void complexes_carray_conjugate(carray_t *result, const carray_t *array);
+void complexes_carray_reciprocol(carray_t *result, const carray_t *array);
+void complexes_carray_power(carray_t *result, const carray_t *array, int n);
+void complexes_carray_roots(carray_t *result, const carray_t *array, int n);
+void complexes_carray_modules(double *result, const carray_t *array);
+void complexes_carray_argument(double *result, const carray_t *array);
+fftplan_t *complexes_fftplan(size_t size, bool_t real);
+void complexes_fftplan_free(fftplan_t *plan);
+void complexes_fft(fftplan_t *plan, carray_t *result, const carray_t *array,
+                   bool_t inverse);
+void complexes_rfft(fftplan_t *plan, carray_t *result, const double *input);
+void complexes_irfft(fftplan_t *plan, double *result, const carray_t *array);
+void complexes_fft2(carray_t *result, const carray_t *array, size_t rows,
+                    size_t cols, bool_t inverse);
 
 /* Cryptography methods */
 
@@ -183,12 +703,66 @@ matrix_t crypts_to_matrix(str_t message, shape_t shape);
 matrix_t crypts_encode(str_t message, matrix_t encoder);
 matrix_t crypts_decode(matrix_t encoded, matrix_t encoder);
 str_t crypts_to_message(matrix_t encoded, matrix_t encoder);
+crypts_key_t crypts_key(matrix_t encoder);
+crypts_key_t crypts_modkey(matrix_t encoder, unsigned int modulus);
+matrix_t crypts_key_encode(const crypts_key_t *key, str_t message);
+matrix_t crypts_key_decode(const crypts_key_t *key, matrix_t encoded);
+str_t crypts_key_to_message(const crypts_key_t *key, matrix_t encoded);
+size_t crypts_mod_size(const crypts_key_t *key, size_t lenght);
+size_t crypts_mod_encode(const crypts_key_t *key, const unsigned char *data,
+                         size_t lenght, unsigned char *encoded);
+size_t crypts_mod_decode(const crypts_key_t *key, const unsigned char *encoded,
+                         size_t lenght, unsigned char *data);
+void crypts_stream_init(crypts_stream_t *stream, const crypts_key_t *key,
+                        bool_t decode, int threads);
+size_t crypts_stream_update(crypts_stream_t *stream, const unsigned char *input,
+                            size_t lenght, unsigned char *output);
+size_t crypts_stream_final(crypts_stream_t *stream, unsigned char *output);
+double *crypts_batch_encode(const crypts_key_t *key, size_t count, 
+                            str_t messages[], size_t offsets[]);
+void crypts_batch_to_messages(const crypts_key_t *key, size_t count,
+                              const double *encoded, const size_t offsets[],
+                              str_t messages[]);
+
+/* Math methods */
+
+void maths_set_mode(mathmode_t mode);
+mathmode_t maths_get_mode(void);
+void maths_sqrt(double *result, const double *x, size_t n);
+void maths_cbrt(double *result, const double *x, size_t n);
+void maths_exp(double *result, const double *x, size_t n);
+void maths_log(double *result, const double *x, size_t n);
+void maths_pow(double *result, const double *x, double exponent, size_t n);
+void maths_sincosd(double *sine, double *cosine, const double *deg, 
+                   size_t n);
+void maths_atan2d(double *result, const double *y, const double *x, 
+                  size_t n);
+void maths_acosd(double *result, const double *x, size_t n);
+void maths_degrees(double *result, const double *x, size_t n);
+void maths_radians(double *result, const double *x, size_t n);
 
 /* Application methods */
 
 vector_t apps_poly_curve_fitting(vector_t xvector, vector_t yvector);
+void apps_poly_eval(double *result, const double *x, size_t count,
+                    const vector_t *coefs);
+spline_t *apps_spline(const double *x, const double *y, size_t count,
+                      splineend_t end, double fslope, double lslope);
+void apps_spline_free(spline_t *spline);
+void apps_spline_eval(double *result, const double *x, size_t count,
+                      const spline_t *spline);
 vector_t apps_least_sqaures_reg(vector_t xvector, vector_t yvector);
+lsq_t *apps_lsq(dim_t features, dim_t degree);
+void apps_lsq_free(lsq_t *lsq);
+void apps_lsq_update(lsq_t *lsq, const double *x, const double *y,
+                     const double *weights, size_t count);
+void apps_lsq_merge(lsq_t *lsq, const lsq_t *other);
+double apps_lsq_solve(const lsq_t *lsq, double *coefs);
 double apps_area(vector_t xvector, vector_t yvector);
 double apps_volume(vector_t xvector, vector_t yvector, vector_t zvector);
+double apps_mesh_area(double *areas, const double *vertices,
+                      const size_t *indices, size_t count);
+double apps_mesh_volume(double *volumes, const double *vertices,
+                        const size_t *indices, size_t count);
 
 #endif /* ALAT_H */
@@ -2,126 +2,616 @@
 
 #include "./alat.h"
 
+/* Count of points which batch kernels process at once */
+#define APPS_CHUNK      65536
+
 /**
  * Apply polynomial curve fitting application. `xvector` and `yvector`
  * are respectively x and y axis points where related-function passes.
+ * i.th element of result is coefficient of x^i. Vandermonde system is
+ * solved with Bjorck-Pereyra algorithm in O(n^2).
  */
 vector_t apps_poly_curve_fitting(vector_t xvector, vector_t yvector)
 {
    vector_t result;
-   matrix_t main, target, mvector, res;
-   int i, j;
+   const double *x = xvector.vector;
+   double *c = result.vector;
+   int i, k, n;
 
    if (xvector.dim != yvector.dim)
       alat_error("Dimension dismatch found");
 
-   // Create the 'mvector' matrix using `yvector` points.
-   mvector.shape.row = 1, mvector.shape.col = yvector.dim;
-   for (i = 0; i < yvector.dim; i++)
-      mvector.matrix[0][i] = yvector.vector[i];
+   n = result.dim = xvector.dim;
+   memcpy(c, yvector.vector, sizeof(double) * n);
 
-   // Create related sub-matrices.
-   main = matrices_zeros((shape_t) {xvector.dim, yvector.dim});
-   target = matrices_transpose(mvector);
+   // Find the divided differences of Newton form.
+   for (k = 0; k < n - 1; k++)
+      for (i = n - 1; i > k; i--) {
+         if (x[i] == x[i-k-1])
+            alat_error("x axis points must be distinct");
+         c[i] = (c[i] - c[i-1]) / (x[i] - x[i-k-1]);
+      }
 
-   // Fill the 'main' matrix using points of 'xvector'.
-   for (i = 0; i < xvector.dim; i++) 
-      for (j = 0; j < xvector.dim; j++) 
-         main.matrix[i][j] = pow(xvector.vector[i], j);
+   // Expand the Newton form into coefficients of powers.
+   for (k = n - 2; k >= 0; k--)
+      for (i = k; i < n - 1; i++)
+         c[i] -= x[k] * c[i+1];
 
-   // Find the polynomial curve fitting in matrix form.
-   res = matrices_cross_mul(matrices_inverse(main), target);
+   return result;
+}
 
-   // Convert the matrix form back to vector and return it.
-   result.dim = xvector.dim;
-   for (i = 0; i < result.dim; i++)
-      result.vector[i] = res.matrix[i][0];
+static ALAT_SIMD void apps_kpoly_eval(double *result, const double *x, 
+                                      size_t n, const double *coefs,
+                                      int degree)
+{
+   double block[256];
+   size_t start, size, i;
+   int k;
 
-   return result;
+   // Horner steps run over a block of points, so each step is vectorized.
+   for (start = 0; start < n; start += size) {
+      size = (n - start < 256) ? n - start : 256;
+      for (i = 0; i < size; i++)
+         block[i] = coefs[degree];
+      for (k = degree - 1; k >= 0; k--)
+         for (i = 0; i < size; i++)
+            block[i] = block[i] * x[start+i] + coefs[k];
+      memcpy(result + start, block, sizeof(double) * size);
+   }
+}
+
+/**
+ * Evaluate the polynomial whose coefficients are in `coefs` (as result
+ * of `apps_poly_curve_fitting`) at `count` points of `x` into `result`.
+ */
+void apps_poly_eval(double *result, const double *x, size_t count,
+                    const vector_t *coefs)
+{
+   long chunk;
+
+   if (coefs->dim == 0)
+      alat_error("Polynomial must have coefficients");
+
+   #pragma omp parallel for if (count > 4 * APPS_CHUNK)
+   for (chunk = 0; chunk < (long) ((count + APPS_CHUNK - 1) / APPS_CHUNK);
+        chunk++) {
+      size_t start = chunk * APPS_CHUNK;
+      size_t size = (count - start < APPS_CHUNK) ? count - start : APPS_CHUNK;
+
+      apps_kpoly_eval(result + start, x + start, size, coefs->vector,
+                      coefs->dim - 1);
+   }
+}
+
+/**
+ * Fit cubic spline which passes through `count` points of `x` and `y`. 
+ * `x` must be strictly increasing. `end` selects the end conditions, and 
+ * `fslope` and `lslope` are first derivatives at first and last knots for
+ * `SPLINE_CLAMPED` (ignored otherwise). Second derivatives of knots are
+ * found with one tridiagonal solve in O(count).
+ */
+spline_t *apps_spline(const double *x, const double *y, size_t count,
+                      splineend_t end, double fslope, double lslope)
+{
+   double *sub, *diag, *sup, *rhs, *step, *slope, *moment, h0, h1, factor;
+   spline_t *spline;
+   size_t n = count, i, k;
+   int span;
+
+   if (count < 2 || (end == SPLINE_NOTAKNOT && count < 4))
+      alat_error("Count of points is not enough for spline");
+   if (count > INT_MAX)
+      alat_error("Count of points is too large for spline");
+   if (end != SPLINE_NATURAL && end != SPLINE_CLAMPED &&
+       end != SPLINE_NOTAKNOT)
+      alat_error("Undefined spline end condition");
+
+   spline = malloc(sizeof(spline_t));
+   if (spline == NULL)
+      alat_error("Memory allocation failed");
+   spline->count = n;
+   spline->knots = malloc(sizeof(double) * (n + 4 * (n - 1)));
+   sub = malloc(sizeof(double) * 7 * n);
+   if (spline->knots == NULL || sub == NULL)
+      alat_error("Memory allocation failed");
+   spline->coefs = spline->knots + n;
+   diag = sub + n, sup = diag + n, rhs = sup + n, step = rhs + n;
+   slope = step + n, moment = slope + n;
+
+   memcpy(spline->knots, x, sizeof(double) * n);
+   for (i = 0; i < n - 1; i++) {
+      step[i] = x[i+1] - x[i];
+      if (!(step[i] > 0.0))
+         alat_error("x axis points must be strictly increasing");
+      slope[i] = (y[i+1] - y[i]) / step[i];
+   }
+
+   // Cells split range of knots equally, and each one keeps the interval
+   // of its start, so searches are limited to intervals in the cell.
+   spline->cells = malloc(sizeof(int) * n);
+   if (spline->cells == NULL)
+      alat_error("Memory allocation failed");
+   h0 = (x[n-1] - x[0]) / (n - 1);
+   for (k = 0, i = 0; i < n - 1; i++) {
+      while (k + 1 < n - 1 && x[k+1] <= x[0] + i * h0)
+         k++;
+      spline->cells[i] = k;
+   }
+   spline->cells[n-1] = n - 2;
+   for (span = 0, i = 0; i < n - 1; i++)
+      if (spline->cells[i+1] - spline->cells[i] > span)
+         span = spline->cells[i+1] - spline->cells[i];
+   for (spline->steps = 0; span > 0; span >>= 1)
+      spline->steps++;
+
+   // Continuity of first derivatives at interior knots.
+   for (i = 1; i < n - 1; i++) {
+      sub[i] = step[i-1], sup[i] = step[i];
+      diag[i] = 2.0 * (step[i-1] + step[i]);
+      rhs[i] = 6.0 * (slope[i] - slope[i-1]);
+   }
+
+   sub[0] = sup[0] = sub[n-1] = sup[n-1] = 0.0;
+   diag[0] = diag[n-1] = 1.0, rhs[0] = rhs[n-1] = 0.0;
+   if (end == SPLINE_CLAMPED) {
+      diag[0] = 2.0 * step[0], sup[0] = step[0];
+      rhs[0] = 6.0 * (slope[0] - fslope);
+      diag[n-1] = 2.0 * step[n-2], sub[n-1] = step[n-2];
+      rhs[n-1] = 6.0 * (lslope - slope[n-2]);
+   }
+   else if (end == SPLINE_NOTAKNOT) {
+      // First and last moments are eliminated from their neighbour rows.
+      h0 = step[0], h1 = step[1];
+      diag[1] = (h0 + h1) * (h0 / h1 + 2.0), sup[1] = h1 - h0 * h0 / h1;
+      sub[1] = 0.0;
+      h0 = step[n-2], h1 = step[n-3];
+      diag[n-2] = (h0 + h1) * (h0 / h1 + 2.0), sub[n-2] = h1 - h0 * h0 / h1;
+      sup[n-2] = 0.0;
+   }
+
+   // Thomas algorithm without pivoting, since interior rows are diagonally
+   // dominant.
+   for (i = 1; i < n; i++) {
+      factor = sub[i] / diag[i-1];
+      diag[i] -= factor * sup[i-1];
+      rhs[i] -= factor * rhs[i-1];
+   }
+   moment[n-1] = rhs[n-1] / diag[n-1];
+   for (i = n - 1; i-- > 0;)
+      moment[i] = (rhs[i] - sup[i] * moment[i+1]) / diag[i];
+
+   if (end == SPLINE_NOTAKNOT) {
+      moment[0] = moment[1] - step[0] * (moment[2] - moment[1]) / step[1];
+      moment[n-1] = moment[n-2] + step[n-2] * (moment[n-2] - moment[n-3]) / 
+                                  step[n-3];
+   }
+
+   for (i = 0; i < n - 1; i++) {
+      spline->coefs[4*i] = y[i];
+      spline->coefs[4*i+1] = slope[i] - step[i] * 
+                             (2.0 * moment[i] + moment[i+1]) / 6.0;
+      spline->coefs[4*i+2] = moment[i] / 2.0;
+      spline->coefs[4*i+3] = (moment[i+1] - moment[i]) / (6.0 * step[i]);
+   }
+
+   free(sub);
+
+   return spline;
+}
+
+/**
+ * Free the memory of `spline`.
+ */
+void apps_spline_free(spline_t *spline)
+{
+   if (spline == NULL)
+      return;
+
+   free(spline->knots), free(spline->cells);
+   free(spline);
+}
+
+/* Evaluate `spline` at `n` points of `x` into `result`. Cell of each point
+   is found by its grid position, then the interval by branch-free search
+   in the cell with fixed steps. Points are processed in blocks, so gathers
+   and Horner steps are vectorized. Points out of knots are extrapolated 
+   with end polynomials. */
+static ALAT_SIMD void apps_kspline(double *result, const double *x,
+                                   const spline_t *spline, size_t n)
+{
+   const double *knots = spline->knots, *coefs = spline->coefs;
+   const int *cells = spline->cells;
+   int index[256], last[256], candidate, step;
+   size_t intervals = spline->count - 1, start, size, i;
+   double inverse, limit, t, point[256];
+
+   inverse = intervals / (knots[intervals] - knots[0]);
+   limit = intervals - 1;
+
+   for (start = 0; start < n; start += size) {
+      size = (n - start < 256) ? n - start : 256;
+      for (i = 0; i < size; i++)
+         point[i] = x[start+i];
+
+      for (i = 0; i < size; i++) {
+         t = (point[i] - knots[0]) * inverse;
+         t = (t < limit) ? t : limit;
+         candidate = (t > 0.0) ? t : 0.0;
+         index[i] = cells[candidate], last[i] = cells[candidate+1];
+      }
+
+      for (step = (1 << spline->steps) >> 1; step > 0; step >>= 1) {
+         for (i = 0; i < size; i++) {
+            candidate = (index[i] + step < last[i]) ? index[i] + step : 
+                                                      last[i];
+            index[i] = (knots[candidate] <= point[i]) ? candidate : index[i];
+         }
+      }
+
+      for (i = 0; i < size; i++) {
+         const double *coef = coefs + 4 * index[i];
+
+         t = point[i] - knots[index[i]];
+         result[start+i] = coef[0] + t * (coef[1] + t * 
+                           (coef[2] + t * coef[3]));
+      }
+   }
+}
+
+/**
+ * Evaluate `spline` at `count` points of `x` into `result`.
+ */
+void apps_spline_eval(double *result, const double *x, size_t count,
+                      const spline_t *spline)
+{
+   long chunk;
+
+   #pragma omp parallel for if (count > 4 * APPS_CHUNK)
+   for (chunk = 0; chunk < (long) ((count + APPS_CHUNK - 1) / APPS_CHUNK);
+        chunk++) {
+      size_t start = chunk * APPS_CHUNK;
+      size_t size = (count - start < APPS_CHUNK) ? count - start : APPS_CHUNK;
+
+      apps_kspline(result + start, x + start, spline, size);
+   }
 }
 
 /**
  * Apply least squares regression application. `xvector` and `yvector` 
  * are respectively x and y axis points where related-function passes.
+ * Result contains a and b of y = a + bx.
  */
 vector_t apps_least_sqaures_reg(vector_t xvector, vector_t yvector)
 {
    vector_t result;
-   matrix_t main, target, res;
-   int i;
+   lsq_t *lsq;
 
    if (xvector.dim != yvector.dim)
       alat_error("Dimension dismatch found");
 
+   lsq = apps_lsq(1, 1);
+   apps_lsq_update(lsq, xvector.vector, yvector.vector, NULL, xvector.dim);
    result.dim = 2;
-   target.shape.row = 1, target.shape.col = yvector.dim;
-   main = matrices_ones((shape_t) {2, xvector.dim});
+   apps_lsq_solve(lsq, result.vector);
+   apps_lsq_free(lsq);
+
+   return result;
+}
 
-   // Complete the 'main' and 'target' matrices using axis vectors.
-   for (i = 0; i < xvector.dim; i++)
-      main.matrix[1][i] = xvector.vector[i];
-   for (i = 0; i < yvector.dim; i++)
-      target.matrix[0][i] = yvector.vector[i];
+/**
+ * Create the accumulator of weighted least squares regression whose model
+ * is polynomial of `degree` in each of `features`, without cross terms.
+ * Coefficients are ordered as intercept, powers 1 to `degree` of first 
+ * feature, then of second feature and so on. Count of coefficients 
+ * (1 + `features` * `degree`) must be at most 64.
+ */
+lsq_t *apps_lsq(dim_t features, dim_t degree)
+{
+   lsq_t *lsq;
 
-   // Make some matrix operations to apply regression.
-   res = matrices_scaler_mul(matrices_cross_mul(matrices_cofactors(
-      matrices_cross_mul(main, matrices_transpose(main))), 
-      matrices_cross_mul(main, matrices_transpose(target))), 0.02);
+   if (features == 0 || degree == 0)
+      alat_error("'features' and 'degree' must be positive");
+   if (1 + (size_t) features * degree > ROW)
+      alat_error("Count of coefficients must be at most 64");
 
-   result.vector[0] = res.matrix[0][0], result.vector[1] = res.matrix[1][0];
+   lsq = calloc(1, sizeof(lsq_t));
+   if (lsq == NULL)
+      alat_error("Memory allocation failed");
 
-   return result;
+   lsq->features = features, lsq->degree = degree;
+   lsq->terms = 1 + features * degree;
+   lsq->xtx = calloc((size_t) lsq->terms * lsq->terms, sizeof(double));
+   lsq->xty = calloc(lsq->terms, sizeof(double));
+   if (lsq->xtx == NULL || lsq->xty == NULL)
+      alat_error("Memory allocation failed");
+
+   return lsq;
+}
+
+/**
+ * Free the memory of `lsq`.
+ */
+void apps_lsq_free(lsq_t *lsq)
+{
+   if (lsq == NULL)
+      return;
+
+   free(lsq->xtx), free(lsq->xty);
+   free(lsq);
+}
+
+/* Add weighted design rows of points [start, end) to `xtx` and `xty`. Rows
+   are built in column-major blocks, so each product is vectorized. */
+static ALAT_SIMD void apps_klsq(const lsq_t *lsq, double *xtx, double *xty,
+                                double *yty, double *weight, const double *x,
+                                const double *y, const double *weights, 
+                                size_t start, size_t end)
+{
+   double block[(ROW + 1) * 64], root, power, total;
+   size_t terms = lsq->terms, size, i, j, k, f, d;
+
+   for (; start < end; start += size) {
+      size = (end - start < 64) ? end - start : 64;
+
+      // Column j holds the j.th term of rows, and last column holds y.
+      for (i = 0; i < size; i++) {
+         root = (weights != NULL) ? sqrt(weights[start+i]) : 1.0;
+         *weight += (weights != NULL) ? weights[start+i] : 1.0;
+         block[i] = root;
+         for (f = 0; f < lsq->features; f++) {
+            power = root;
+            for (d = 0; d < lsq->degree; d++) {
+               power *= x[(start+i)*lsq->features+f];
+               block[(1+f*lsq->degree+d)*64+i] = power;
+            }
+         }
+         block[terms*64+i] = root * y[start+i];
+      }
+
+      for (j = 0; j <= terms; j++) {
+         for (k = j; k <= terms; k++) {
+            for (total = 0.0, i = 0; i < size; i++)
+               total += block[j*64+i] * block[k*64+i];
+            if (k < terms)
+               xtx[j*terms+k] += total;
+            else if (j < terms)
+               xty[j] += total;
+            else
+               *yty += total;
+         }
+      }
+   }
+}
+
+/**
+ * Add `count` points to `lsq`. `x` has `features` values of each point 
+ * in row-major, and `y` has targets. `weights` may be NULL for unit 
+ * weights. Large batches are split between threads, and each thread has
+ * its own partial sums which are merged at the end.
+ */
+void apps_lsq_update(lsq_t *lsq, const double *x, const double *y,
+                     const double *weights, size_t count)
+{
+   #pragma omp parallel if (count > 4 * APPS_CHUNK)
+   {
+      size_t size = (size_t) lsq->terms * lsq->terms;
+      double *xtx, *xty, yty = 0.0, weight = 0.0;
+      long chunk;
+
+      xtx = calloc(size + lsq->terms, sizeof(double));
+      if (xtx == NULL)
+         alat_error("Memory allocation failed");
+      xty = xtx + size;
+
+      #pragma omp for
+      for (chunk = 0; chunk < (long) ((count + APPS_CHUNK - 1) / APPS_CHUNK);
+           chunk++) {
+         size_t start = chunk * APPS_CHUNK;
+         size_t end = (count - start < APPS_CHUNK) ? count : 
+                                                     start + APPS_CHUNK;
+
+         apps_klsq(lsq, xtx, xty, &yty, &weight, x, y, weights, start, end);
+      }
+
+      #pragma omp critical
+      {
+         vectors_axpy(size, 1.0, xtx, lsq->xtx);
+         vectors_axpy(lsq->terms, 1.0, xty, lsq->xty);
+         lsq->yty += yty, lsq->weight += weight;
+      }
+
+      free(xtx);
+   }
+}
+
+/**
+ * Merge the points of `other` into `lsq`. Both must have same model, so
+ * accumulators of separate threads or streams can be combined.
+ */
+void apps_lsq_merge(lsq_t *lsq, const lsq_t *other)
+{
+   if (lsq->features != other->features || lsq->degree != other->degree)
+      alat_error("Models of accumulators must be same");
+
+   vectors_axpy((size_t) lsq->terms * lsq->terms, 1.0, other->xtx, lsq->xtx);
+   vectors_axpy(lsq->terms, 1.0, other->xty, lsq->xty);
+   lsq->yty += other->yty, lsq->weight += other->weight;
+}
+
+/**
+ * Solve the normal equations of `lsq` with Cholesky factorization, and 
+ * write the coefficients to `coefs`, which has `terms` elements. Return 
+ * the weighted sum of squared residuals. `lsq` is not changed, so more
+ * points can be added after solving.
+ */
+double apps_lsq_solve(const lsq_t *lsq, double *coefs)
+{
+   double factor[ROW][ROW], total, scale;
+   int n = lsq->terms, i, j, k;
+
+   // Find the lower triangular L of X^T X = L L^T.
+   for (scale = 0.0, i = 0; i < n; i++)
+      scale = fmax(scale, lsq->xtx[i*n+i]);
+   for (j = 0; j < n; j++) {
+      for (total = lsq->xtx[j*n+j], k = 0; k < j; k++)
+         total -= factor[j][k] * factor[j][k];
+      if (total <= scale * n * DBL_EPSILON)
+         alat_error("Least squares system is singular");
+      factor[j][j] = sqrt(total);
+
+      for (i = j + 1; i < n; i++) {
+         for (total = lsq->xtx[j*n+i], k = 0; k < j; k++)
+            total -= factor[i][k] * factor[j][k];
+         factor[i][j] = total / factor[j][j];
+      }
+   }
+
+   // Solve L z = X^T y, then L^T c = z.
+   for (i = 0; i < n; i++) {
+      for (total = lsq->xty[i], k = 0; k < i; k++)
+         total -= factor[i][k] * coefs[k];
+      coefs[i] = total / factor[i][i];
+   }
+   for (i = n - 1; i >= 0; i--) {
+      for (total = coefs[i], k = i + 1; k < n; k++)
+         total -= factor[k][i] * coefs[k];
+      coefs[i] = total / factor[i][i];
+   }
+
+   // Residual is y^T y - c^T X^T y at the solution.
+   total = lsq->yty - vectors_dot(n, coefs, lsq->xty);
+   return (total < 0.0) ? 0.0 : total;
 }
 
 /**
- * Calculate the area of triangle using determinant where 
+ * Calculate the area of triangle using cross product where 
  * corners of that triangle are in `xvector` and `yvector`.
  */
 double apps_area(vector_t xvector, vector_t yvector)
 {
-   matrix_t main;
-   int i;
-   double result;
+   double *x = xvector.vector, *y = yvector.vector;
 
    if ((xvector.dim != yvector.dim) || (xvector.dim != 3) ||
        (yvector.dim != 3))
       alat_error("Dimension dismatch found");
 
-   main = matrices_ones((shape_t) {3, 3});
-
-   for (i = 0; i < xvector.dim; i++) {
-      main.matrix[0][i] = xvector.vector[i];
-      main.matrix[1][i] = yvector.vector[i];
-   }
-
-   result = matrices_det(matrices_transpose(main)) / 2.0;
-
-   return (result < 0) ? (-1.0 * result) : result;
+   return fabs((x[1] - x[0]) * (y[2] - y[0]) - 
+               (x[2] - x[0]) * (y[1] - y[0])) / 2.0;
 }
 
 /**
- * Calculate the volume of tetrahedron using determinant where corners
+ * Calculate the volume of tetrahedron using triple product where corners
  * of that tetrahedron are in `xvector`, `yvector` and `zvector.`
  */
 double apps_volume(vector_t xvector, vector_t yvector, vector_t zvector)
 {
-   matrix_t main;
-   int i;
-   double result;
+   double *x = xvector.vector, *y = yvector.vector, *z = zvector.vector;
+   double ax, ay, az, bx, by, bz, cx, cy, cz;
 
    if ((xvector.dim != yvector.dim) || (yvector.dim != zvector.dim) ||
        (xvector.dim != 4) || (yvector.dim != 4) || (zvector.dim != 4))
       alat_error("Dimension dismatch found");
 
-   main = matrices_ones((shape_t) {4, 4});
+   ax = x[1] - x[0], ay = y[1] - y[0], az = z[1] - z[0];
+   bx = x[2] - x[0], by = y[2] - y[0], bz = z[2] - z[0];
+   cx = x[3] - x[0], cy = y[3] - y[0], cz = z[3] - z[0];
+
+   return fabs(ax * (by * cz - bz * cy) - ay * (bx * cz - bz * cx) +
+               az * (bx * cy - by * cx)) / 6.0;
+}
+
+/* Calculate measures of elements [start, end) of mesh into `result` (if it
+   is not NULL), and return their sum. Each element has `corners` indices,
+   3 for triangles and 4 for tetrahedrons. Corners are gathered into blocks
+   of edge vectors, so cross and triple products are vectorized. */
+static ALAT_SIMD double apps_kmesh(double *result, const double *vertices,
+                                   const size_t *indices, dim_t corners,
+                                   size_t start, size_t end)
+{
+   double edge[3][3][256], measure[256], total = 0.0, ux, uy, uz;
+   const double *origin, *corner;
+   size_t size, i;
+   dim_t j;
+
+   for (; start < end; start += size) {
+      size = (end - start < 256) ? end - start : 256;
+
+      for (i = 0; i < size; i++) {
+         origin = vertices + 3 * indices[(start+i)*corners];
+         for (j = 1; j < corners; j++) {
+            corner = vertices + 3 * indices[(start+i)*corners+j];
+            edge[j-1][0][i] = corner[0] - origin[0];
+            edge[j-1][1][i] = corner[1] - origin[1];
+            edge[j-1][2][i] = corner[2] - origin[2];
+         }
+      }
 
-   for (i = 0; i < xvector.dim; i++) {
-      main.matrix[0][i] = xvector.vector[i];
-      main.matrix[1][i] = yvector.vector[i];
-      main.matrix[2][i] = zvector.vector[i];
+      if (corners == 3) {
+         for (i = 0; i < size; i++) {
+            ux = edge[0][1][i] * edge[1][2][i] - edge[0][2][i] * edge[1][1][i];
+            uy = edge[0][2][i] * edge[1][0][i] - edge[0][0][i] * edge[1][2][i];
+            uz = edge[0][0][i] * edge[1][1][i] - edge[0][1][i] * edge[1][0][i];
+            measure[i] = sqrt(ux * ux + uy * uy + uz * uz) / 2.0;
+         }
+      }
+      else {
+         for (i = 0; i < size; i++) {
+            ux = edge[1][1][i] * edge[2][2][i] - edge[1][2][i] * edge[2][1][i];
+            uy = edge[1][2][i] * edge[2][0][i] - edge[1][0][i] * edge[2][2][i];
+            uz = edge[1][0][i] * edge[2][1][i] - edge[1][1][i] * edge[2][0][i];
+            measure[i] = fabs(edge[0][0][i] * ux + edge[0][1][i] * uy + 
+                              edge[0][2][i] * uz) / 6.0;
+         }
+      }
+
+      for (i = 0; i < size; i++)
+         total += measure[i];
+      if (result != NULL)
+         memcpy(result + start, measure, sizeof(double) * size);
    }
 
-   result = matrices_det(matrices_transpose(main)) / 6.0;
+   return total;
+}
+
+/* Run mesh kernel on chunks of `count` elements between threads. */
+static double apps_mesh(double *result, const double *vertices,
+                        const size_t *indices, size_t count, dim_t corners)
+{
+   double total = 0.0;
+   long chunk;
+
+   #pragma omp parallel for reduction(+:total) if (count > 4 * APPS_CHUNK)
+   for (chunk = 0; chunk < (long) ((count + APPS_CHUNK - 1) / APPS_CHUNK);
+        chunk++) {
+      size_t start = chunk * APPS_CHUNK;
+      size_t end = (count - start < APPS_CHUNK) ? count : start + APPS_CHUNK;
+
+      total += apps_kmesh(result, vertices, indices, corners, start, end);
+   }
+
+   return total;
+}
 
-   return (result < 0) ? (-1.0 * result) : result;
+/**
+ * Calculate the areas of `count` triangles of mesh into `areas`, and return
+ * the total area. `vertices` has x, y and z of each vertex (z is zero for
+ * planar meshes), and `indices` has 3 vertex indices of each triangle. 
+ * `areas` may be NULL when only the total is needed.
+ */
+double apps_mesh_area(double *areas, const double *vertices,
+                      const size_t *indices, size_t count)
+{
+   return apps_mesh(areas, vertices, indices, count, 3);
+}
+
+/**
+ * Calculate the volumes of `count` tetrahedrons of mesh into `volumes`, 
+ * and return the total volume. `vertices` has x, y and z of each vertex,
+ * and `indices` has 4 vertex indices of each tetrahedron. `volumes` may be
+ * NULL when only the total is needed.
+ */
+double apps_mesh_volume(double *volumes, const double *vertices,
+                        const size_t *indices, size_t count)
+{
+   return apps_mesh(volumes, vertices, indices, count, 4);
 }
@@ -74,46 +74,257 @@ complex_t complexes_zero(str_t output_form)
 }
 
 /**
- * Transform `complex` number into particular `new_form`. Consistent forms that 
- * complex number can get are `cartesian` and `polar`. Note that in this module,
- * all angle will be represented as degrees (not radians). 
+ * Parse the `form` string into form enumeration. `form` must be 
+ * `cartesian` or `polar`.
  */
-complex_t complexes_transform(complex_t complex, str_t new_form)
+static form_t complexes_form(str_t form)
+{
+   if (!strcmp(form, "cartesian"))
+      return FORM_CARTESIAN;
+   else if (!strcmp(form, "polar"))
+      return FORM_POLAR;
+   else
+      alat_error("Complex number form must be 'cartesian' or 'polar'");
+}
+
+/**
+ * Create the complex value from `real` and `imaginary` portions.
+ */
+cnum_t complexes_cnum(double real, double imaginary)
+{
+   return (cnum_t) {real, imaginary};
+}
+
+/**
+ * Create the complex value from `modules` and `argument` (in degrees)
+ * portions of polar form.
+ */
+cnum_t complexes_cnum_polar(double modules, double argument)
+{
+   double sine, cosine;
+
+   alat_sincosd(argument, &sine, &cosine, true);
+
+   return (cnum_t) {modules * cosine, modules * sine};
+}
+
+/**
+ * Convert the `complex` number into complex value.
+ */
+cnum_t complexes_to_cnum(complex_t complex)
+{
+   if (complexes_form(complex.form) == FORM_CARTESIAN)
+      return (cnum_t) {complex.complex[0], complex.complex[1]};
+   else
+      return complexes_cnum_polar(complex.complex[0], complex.complex[1]);
+}
+
+/**
+ * Convert the complex value `z` into complex number. `form` indicates
+ * the output form of complex number.
+ */
+complex_t complexes_from_cnum(cnum_t z, form_t form)
 {
    complex_t result;
 
-   if (!strcmp(complex.form, "cartesian") && !strcmp(new_form, "cartesian")) {
-      memcpy(&result, &complex, sizeof(complex));
-   }
-   else if (!strcmp(complex.form, "cartesian") && !strcmp(new_form, "polar")) {
-      result.form = "polar";
-      result.complex[0] = sqrt(pow(complex.complex[0], 2) + pow(complex.complex[1], 2));
-      result.complex[1] = DEG(atan(complex.complex[1] / complex.complex[0])) + 180.0;
-   }
-   else if (!strcmp(complex.form, "polar") && !strcmp(new_form, "cartesian")) {
+   if (form == FORM_CARTESIAN) {
       result.form = "cartesian";
-      result.complex[0] = complex.complex[0] * cos(RAD(complex.complex[1]));
-      result.complex[1] = complex.complex[0] * sin(RAD(complex.complex[1]));
+      result.complex[0] = z.re, result.complex[1] = z.im;
    }
-   else if (!strcmp(complex.form, "polar") && !strcmp(new_form, "polar")) {
-      memcpy(&result, &complex, sizeof(complex));
+   else if (form == FORM_POLAR) {
+      result.form = "polar";
+      result.complex[0] = complexes_cabs(z);
+      result.complex[1] = complexes_carg(z);
    }
    else
       alat_error("Complex number form must be 'cartesian' or 'polar'");
-   
+
    return result;
 }
 
+/**
+ * Return the modules of complex value `z`.
+ */
+double complexes_cabs(cnum_t z)
+{
+   return hypot(z.re, z.im);
+}
+
+/**
+ * Return the argument of complex value `z` in degrees.
+ */
+double complexes_carg(cnum_t z)
+{
+   return DEG(atan2(z.im, z.re));
+}
+
+/**
+ * Add up the complex values `fz` and `sz`.
+ */
+cnum_t complexes_cadd(cnum_t fz, cnum_t sz)
+{
+   return (cnum_t) {fz.re + sz.re, fz.im + sz.im};
+}
+
+/**
+ * Subtract the complex value `sz` from `fz`.
+ */
+cnum_t complexes_csub(cnum_t fz, cnum_t sz)
+{
+   return (cnum_t) {fz.re - sz.re, fz.im - sz.im};
+}
+
+/**
+ * Multiply the complex values `fz` and `sz`.
+ */
+cnum_t complexes_cmul(cnum_t fz, cnum_t sz)
+{
+   return (cnum_t) {fz.re * sz.re - fz.im * sz.im, 
+                    fz.re * sz.im + fz.im * sz.re};
+}
+
+/* Divide `fz` by `sz` after scaling both by powers of two so that their
+   larger parts are in [1, 2). Squares and products then can't overflow or
+   underflow, and scaling is exact. Zeros, infinities and NaNs of `sz` and
+   non-finite `fz` are divided directly. */
+static cnum_t complexes_cdiv_scaled(cnum_t fz, cnum_t sz)
+{
+   double denom, re, im;
+   int fexp, sexp;
+
+   if (!isfinite(fz.re) || !isfinite(fz.im) || !isfinite(sz.re) ||
+       !isfinite(sz.im) || (sz.re == 0.0 && sz.im == 0.0)) {
+      denom = sz.re * sz.re + sz.im * sz.im;
+      return (cnum_t) {(fz.re * sz.re + fz.im * sz.im) / denom,
+                       (fz.im * sz.re - fz.re * sz.im) / denom};
+   }
+
+   fexp = (fz.re == 0.0 && fz.im == 0.0) ? 0 :
+          ilogb(fmax(fabs(fz.re), fabs(fz.im)));
+   sexp = ilogb(fmax(fabs(sz.re), fabs(sz.im)));
+   fz.re = scalbn(fz.re, -fexp), fz.im = scalbn(fz.im, -fexp);
+   sz.re = scalbn(sz.re, -sexp), sz.im = scalbn(sz.im, -sexp);
+
+   denom = sz.re * sz.re + sz.im * sz.im;
+   re = (fz.re * sz.re + fz.im * sz.im) / denom;
+   im = (fz.im * sz.re - fz.re * sz.im) / denom;
+
+   return (cnum_t) {scalbn(re, fexp - sexp), scalbn(im, fexp - sexp)};
+}
+
+/**
+ * Divide the complex value `fz` by `sz`. Both are scaled by powers of two
+ * first, so large and tiny values don't overflow or underflow in squares.
+ */
+cnum_t complexes_cdiv(cnum_t fz, cnum_t sz)
+{
+   return complexes_cdiv_scaled(fz, sz);
+}
+
+/**
+ * Get the conjugate of complex value `z`.
+ */
+cnum_t complexes_cconj(cnum_t z)
+{
+   return (cnum_t) {z.re, -z.im};
+}
+
+/**
+ * Get the reciprocol of complex value `z`, which is scaled by powers of two
+ * first like in division.
+ */
+cnum_t complexes_crecip(cnum_t z)
+{
+   return complexes_cdiv_scaled((cnum_t) {1.0, 0.0}, z);
+}
+
+/**
+ * Get the `n`.th integer power of complex value `z` using repeated 
+ * squaring in cartesian form (no trigonometry).
+ */
+cnum_t complexes_cpowi(cnum_t z, int n)
+{
+   cnum_t result;
+   unsigned int k;
+
+   result = complexes_cnum(1.0, 0.0);
+
+   for (k = (n < 0) ? -(unsigned int) n : (unsigned int) n; k; k >>= 1) {
+      if (k & 1)
+         result = complexes_cmul(result, z);
+      if (k > 1)
+         z = complexes_cmul(z, z);
+   }
+
+   return (n < 0) ? complexes_crecip(result) : result;
+}
+
+/**
+ * Get the `n`.th power of complex value `z`. Integer powers are 
+ * calculated with `complexes_cpowi`.
+ */
+cnum_t complexes_cpow(cnum_t z, double n)
+{
+   if (n == floor(n) && fabs(n) <= INT_MAX)
+      return complexes_cpowi(z, (int) n);
+
+   return complexes_cnum_polar(pow(complexes_cabs(z), n), 
+                               complexes_carg(z) * n);
+}
+
+/**
+ * Get the principal `n`.th root of complex value `z`.
+ */
+cnum_t complexes_croot(cnum_t z, double n)
+{
+   return complexes_cnum_polar(pow(complexes_cabs(z), 1 / n), 
+                               complexes_carg(z) / n);
+}
+
+/**
+ * Get all `n` of `n`.th roots of complex value `z` into `roots`. Only 
+ * the principal root and the step between roots use trigonometry, the 
+ * others are obtained by rotating the previous root.
+ */
+void complexes_croots(cnum_t z, int n, cnum_t roots[])
+{
+   cnum_t step;
+   int k;
+
+   if (n < 1)
+      alat_error("'n' must be positive");
+
+   roots[0] = complexes_croot(z, n);
+   step = complexes_cnum_polar(1.0, 360.0 / n);
+
+   for (k = 1; k < n; k++)
+      roots[k] = complexes_cmul(roots[k-1], step);
+}
+
+/**
+ * Transform `complex` number into particular `new_form`. Consistent forms that 
+ * complex number can get are `cartesian` and `polar`. Note that in this module,
+ * all angle will be represented as degrees (not radians). 
+ */
+complex_t complexes_transform(complex_t complex, str_t new_form)
+{
+   form_t form;
+
+   form = complexes_form(new_form);
+
+   if (complexes_form(complex.form) == form)
+      return complex;
+
+   return complexes_from_cnum(complexes_to_cnum(complex), form);
+}
+
 /**
  * Return the real portion of `complex` number. If `complex` 
  * number defined in polar form, convert it to cartesian form. 
  */
 double complexes_real(complex_t complex)
 {
-   if (!strcmp(complex.form, "cartesian"))
-      return complex.complex[0];
-   else
-      return complexes_transform(complex, "cartesian").complex[0];
+   return complexes_to_cnum(complex).re;
 }
 
 /**
@@ -122,10 +333,7 @@ double complexes_real(complex_t complex)
  */
 double complexes_imaginary(complex_t complex)
 {
-   if (!strcmp(complex.form, "cartesian"))
-      return complex.complex[1];
-   else
-      return complexes_transform(complex, "cartesian").complex[1];
+   return complexes_to_cnum(complex).im;
 }
 
 /**
@@ -134,10 +342,10 @@ double complexes_imaginary(complex_t complex)
  */
 double complexes_modules(complex_t complex)
 {
-   if (!strcmp(complex.form, "polar"))
+   if (complexes_form(complex.form) == FORM_POLAR)
       return complex.complex[0];
    else
-      return complexes_transform(complex, "polar").complex[0];  
+      return complexes_cabs(complexes_to_cnum(complex));
 }
 
 /**
@@ -146,10 +354,10 @@ double complexes_modules(complex_t complex)
  */
 double complexes_argument(complex_t complex)
 {
-   if (!strcmp(complex.form, "polar"))
+   if (complexes_form(complex.form) == FORM_POLAR)
       return complex.complex[1];
    else
-      return complexes_transform(complex, "polar").complex[1]; 
+      return complexes_carg(complexes_to_cnum(complex));
 }
 
 /**
@@ -159,16 +367,8 @@ double complexes_argument(complex_t complex)
  */
 complex_t complexes_add(complex_t fcomplex, complex_t scomplex, str_t output_form)
 {
-   complex_t result;
-
-   result = complexes_zero("cartesian");
-
-   result.complex[0] = complexes_transform(fcomplex, "cartesian").complex[0] + 
-      complexes_transform(scomplex, "cartesian").complex[0];
-   result.complex[1] = complexes_transform(fcomplex, "cartesian").complex[1] + 
-      complexes_transform(scomplex, "cartesian").complex[1];
-
-   return complexes_transform(result, output_form);
+   return complexes_from_cnum(complexes_cadd(complexes_to_cnum(fcomplex),
+      complexes_to_cnum(scomplex)), complexes_form(output_form));
 }
 
 /**
@@ -177,16 +377,8 @@ complex_t complexes_add(complex_t fcomplex, complex_t scomplex, str_t output_for
  */
 complex_t complexes_subtract(complex_t fcomplex, complex_t scomplex, str_t output_form)
 {
-   complex_t result;
-
-   result = complexes_zero("cartesian");
-
-   result.complex[0] = complexes_transform(fcomplex, "cartesian").complex[0] -
-      complexes_transform(scomplex, "cartesian").complex[0];
-   result.complex[1] = complexes_transform(fcomplex, "cartesian").complex[1] -
-      complexes_transform(scomplex, "cartesian").complex[1];
-
-   return complexes_transform(result, output_form);
+   return complexes_from_cnum(complexes_csub(complexes_to_cnum(fcomplex),
+      complexes_to_cnum(scomplex)), complexes_form(output_form));
 }
 
 /**
@@ -195,16 +387,8 @@ complex_t complexes_subtract(complex_t fcomplex, complex_t scomplex, str_t outpu
  */
 complex_t complexes_multiply(complex_t fcomplex, complex_t scomplex, str_t output_form)
 {
-   complex_t result;
-
-   result = complexes_zero("polar");
-
-   result.complex[0] = complexes_transform(fcomplex, "polar").complex[0] *
-      complexes_transform(scomplex, "polar").complex[0];
-   result.complex[1] = complexes_transform(fcomplex, "polar").complex[1] +
-      complexes_transform(scomplex, "polar").complex[1];
-
-   return complexes_transform(result, output_form);
+   return complexes_from_cnum(complexes_cmul(complexes_to_cnum(fcomplex),
+      complexes_to_cnum(scomplex)), complexes_form(output_form));
 }
 
 /**
@@ -213,71 +397,818 @@ complex_t complexes_multiply(complex_t fcomplex, complex_t scomplex, str_t outpu
  */
 complex_t complexes_divide(complex_t fcomplex, complex_t scomplex, str_t output_form)
 {
-   complex_t result;
+   return complexes_from_cnum(complexes_cdiv(complexes_to_cnum(fcomplex),
+      complexes_to_cnum(scomplex)), complexes_form(output_form));
+}
 
-   result = complexes_zero("polar");
+/**
+ * Get the `n`.th power of `complex` number. The result complex number 
+ * will be in form of `output_form` and must be `cartesian` or `polar`.
+ */
+complex_t complexes_power(complex_t complex, double n, str_t output_form)
+{
+   return complexes_from_cnum(complexes_cpow(complexes_to_cnum(complex), n),
+      complexes_form(output_form));
+}
 
-   result.complex[0] = complexes_transform(fcomplex, "polar").complex[0] /
-      complexes_transform(scomplex, "polar").complex[0];
-   result.complex[1] = complexes_transform(fcomplex, "polar").complex[1] -
-      complexes_transform(scomplex, "polar").complex[1];
+/**
+ * Get the `n`.th root of `complex` number. The result complex number 
+ * will be in form of `output_form` and must be `cartesian` or `polar`.
+ */
+complex_t complexes_root(complex_t complex, double n, str_t output_form)
+{
+   return complexes_from_cnum(complexes_croot(complexes_to_cnum(complex), n),
+      complexes_form(output_form));
+}
 
-   return complexes_transform(result, output_form);
+/**
+ * Get the conjugate of `complex` number. The result complex number 
+ * will be in form of `output_form` and must be `cartesian` or `polar`.
+ */
+complex_t complexes_conjugate(complex_t complex, str_t output_form)
+{
+   return complexes_from_cnum(complexes_cconj(complexes_to_cnum(complex)),
+      complexes_form(output_form));
 }
 
 /**
- * Get the `n`.th power of `complex` number. The result complex number 
+ * Get the reciprocol of `complex` number. The result complex number 
  * will be in form of `output_form` and must be `cartesian` or `polar`.
  */
-complex_t complexes_power(complex_t complex, double n, str_t output_form)
+complex_t complexes_reciprocol(complex_t complex, str_t output_form)
 {
-   complex_t result;
+   return complexes_from_cnum(complexes_crecip(complexes_to_cnum(complex)),
+      complexes_form(output_form));
+}
+
+/**
+ * Create a new complex array which has `size` zero complex values. Real
+ * and imaginary portions are stored in separate arrays.
+ */
+carray_t complexes_carray(size_t size)
+{
+   carray_t result;
 
-   result = complexes_zero("polar");
+   result.size = size;
+   result.re = calloc(size ? size : 1, sizeof(com_t));
+   result.im = calloc(size ? size : 1, sizeof(com_t));
 
-   result.complex[0] = pow(complexes_transform(complex, "polar").complex[0], n);
-   result.complex[1] = complexes_transform(complex, "polar").complex[1] * n;
+   if (result.re == NULL || result.im == NULL)
+      alat_error("Memory allocation failed");
 
-   return complexes_transform(result, output_form);  
+   return result;
 }
 
 /**
- * Get the `n`.th root of `complex` number. The result complex number 
- * will be in form of `output_form` and must be `cartesian` or `polar`.
+ * Release the memory of complex `array`.
  */
-complex_t complexes_root(complex_t complex, double n, str_t output_form)
+void complexes_carray_free(carray_t *array)
 {
-   complex_t result;
+   free(array->re), free(array->im);
+   array->re = NULL, array->im = NULL, array->size = 0;
+}
+
+/* Complex array kernels which process elements in [start, end). */
+
+typedef void (*carray_kernel_t)(carray_t *result, const carray_t *farray,
+                                const carray_t *sarray, size_t start,
+                                size_t end, int n);
+
+static ALAT_SIMD void complexes_kadd(carray_t *result, const carray_t *farray,
+   const carray_t *sarray, size_t start, size_t end, int n)
+{
+   const double *fre = farray->re, *fim = farray->im;
+   const double *sre = sarray->re, *sim = sarray->im;
+   double *rre = result->re, *rim = result->im;
+
+   for (size_t i = start; i < end; i++)
+      rre[i] = fre[i] + sre[i], rim[i] = fim[i] + sim[i];
+}
+
+static ALAT_SIMD void complexes_ksub(carray_t *result, const carray_t *farray,
+   const carray_t *sarray, size_t start, size_t end, int n)
+{
+   const double *fre = farray->re, *fim = farray->im;
+   const double *sre = sarray->re, *sim = sarray->im;
+   double *rre = result->re, *rim = result->im;
+
+   for (size_t i = start; i < end; i++)
+      rre[i] = fre[i] - sre[i], rim[i] = fim[i] - sim[i];
+}
+
+static ALAT_SIMD void complexes_kmul(carray_t *result, const carray_t *farray,
+   const carray_t *sarray, size_t start, size_t end, int n)
+{
+   const double *fre = farray->re, *fim = farray->im;
+   const double *sre = sarray->re, *sim = sarray->im;
+   double *rre = result->re, *rim = result->im;
+   double re, im;
+
+   for (size_t i = start; i < end; i++) {
+      re = fre[i] * sre[i] - fim[i] * sim[i];
+      im = fre[i] * sim[i] + fim[i] * sre[i];
+      rre[i] = re, rim[i] = im;
+   }
+}
+
+static ALAT_SIMD void complexes_kdiv(carray_t *result, const carray_t *farray,
+   const carray_t *sarray, size_t start, size_t end, int n)
+{
+   const double *fre = farray->re, *fim = farray->im;
+   const double *sre = sarray->re, *sim = sarray->im;
+   double *rre = result->re, *rim = result->im;
+   double re[256], im[256], denom, fbound, sbound;
+   cnum_t z;
+   size_t i, j, size;
+
+   for (i = start; i < end; i += 256) {
+      size = (end - i < 256) ? end - i : 256;
+
+      for (j = 0; j < size; j++) {
+         denom = 1.0 / (sre[i+j] * sre[i+j] + sim[i+j] * sim[i+j]);
+         re[j] = (fre[i+j] * sre[i+j] + fim[i+j] * sim[i+j]) * denom;
+         im[j] = (fim[i+j] * sre[i+j] - fre[i+j] * sim[i+j]) * denom;
+      }
+
+      // Squares and products stay normal while parts of both values are
+      // in [2^-500, 2^500]. Other lanes are divided again after scaling.
+      for (j = 0; j < size; j++) {
+         fbound = fmax(fabs(fre[i+j]), fabs(fim[i+j]));
+         sbound = fmax(fabs(sre[i+j]), fabs(sim[i+j]));
+
+         if (sbound >= 0x1p-500 && sbound <= 0x1p500 && fbound <= 0x1p500 &&
+             (fbound >= 0x1p-500 || fbound == 0.0)) {
+            rre[i+j] = re[j], rim[i+j] = im[j];
+         }
+         else {
+            z = complexes_cdiv_scaled((cnum_t) {fre[i+j], fim[i+j]},
+                                      (cnum_t) {sre[i+j], sim[i+j]});
+            rre[i+j] = z.re, rim[i+j] = z.im;
+         }
+      }
+   }
+}
 
-   result = complexes_zero("polar");
+static ALAT_SIMD void complexes_kconj(carray_t *result, const carray_t *farray,
+   const carray_t *sarray, size_t start, size_t end, int n)
+{
+   const double *fre = farray->re, *fim = farray->im;
+   double *rre = result->re, *rim = result->im;
+
+   for (size_t i = start; i < end; i++)
+      rre[i] = fre[i], rim[i] = -fim[i];
+}
+
+static ALAT_SIMD void complexes_krecip(carray_t *result, const carray_t *farray,
+   const carray_t *sarray, size_t start, size_t end, int n)
+{
+   const double *fre = farray->re, *fim = farray->im;
+   double *rre = result->re, *rim = result->im;
+   double re[256], im[256], denom, bound;
+   cnum_t z;
+   size_t i, j, size;
+
+   for (i = start; i < end; i += 256) {
+      size = (end - i < 256) ? end - i : 256;
+
+      for (j = 0; j < size; j++) {
+         denom = 1.0 / (fre[i+j] * fre[i+j] + fim[i+j] * fim[i+j]);
+         re[j] = fre[i+j] * denom, im[j] = -fim[i+j] * denom;
+      }
+
+      // Lanes out of [2^-500, 2^500] are recalculated after scaling.
+      for (j = 0; j < size; j++) {
+         bound = fmax(fabs(fre[i+j]), fabs(fim[i+j]));
+
+         if (bound >= 0x1p-500 && bound <= 0x1p500) {
+            rre[i+j] = re[j], rim[i+j] = im[j];
+         }
+         else {
+            z = complexes_cdiv_scaled((cnum_t) {1.0, 0.0},
+                                      (cnum_t) {fre[i+j], fim[i+j]});
+            rre[i+j] = z.re, rim[i+j] = z.im;
+         }
+      }
+   }
+}
+
+static ALAT_SIMD void complexes_kabs(carray_t *result, const carray_t *farray,
+   const carray_t *sarray, size_t start, size_t end, int n)
+{
+   const double *fre = farray->re, *fim = farray->im;
+   double *rre = result->re, modules[256];
+   size_t i, j, size;
+
+   for (i = start; i < end; i += 256) {
+      size = (end - i < 256) ? end - i : 256;
+
+      for (j = 0; j < size; j++)
+         modules[j] = sqrt(fre[i+j] * fre[i+j] + fim[i+j] * fim[i+j]);
+
+      // Lanes whose squares overflowed or underflowed into subnormals (and 
+      // non-finite inputs) are recalculated by scaled hypot.
+      for (j = 0; j < size; j++)
+         rre[i+j] = (modules[j] >= 0x1p-511 && modules[j] <= DBL_MAX) ? 
+                    modules[j] : hypot(fre[i+j], fim[i+j]);
+   }
+}
+
+static void complexes_karg(carray_t *result, const carray_t *farray,
+   const carray_t *sarray, size_t start, size_t end, int n)
+{
+   maths_atan2d(result->re + start, farray->im + start, farray->re + start,
+                end - start);
+}
+
+static ALAT_SIMD void complexes_kpowi(carray_t *result, const carray_t *farray,
+   const carray_t *sarray, size_t start, size_t end, int n)
+{
+   const double *fre = farray->re, *fim = farray->im;
+   double *rre = result->re, *rim = result->im;
+   double bre[256], bim[256], pre[256], pim[256], re, im, denom;
+   unsigned int k;
+   size_t i, j, size;
+
+   // Apply repeated squaring on blocks, so that each squaring step
+   // is a plain loop over the block.
+   for (i = start; i < end; i += 256) {
+      size = (end - i < 256) ? end - i : 256;
+
+      for (j = 0; j < size; j++)
+         bre[j] = fre[i+j], bim[j] = fim[i+j], pre[j] = 1.0, pim[j] = 0.0;
 
-   result.complex[0] = pow(complexes_transform(complex, "polar").complex[0], 1/n);
-   result.complex[1] = complexes_transform(complex, "polar").complex[1] / n;
+      for (k = (n < 0) ? -(unsigned int) n : (unsigned int) n; k; k >>= 1) {
+         if (k & 1)
+            for (j = 0; j < size; j++) {
+               re = pre[j] * bre[j] - pim[j] * bim[j];
+               im = pre[j] * bim[j] + pim[j] * bre[j];
+               pre[j] = re, pim[j] = im;
+            }
+         if (k > 1)
+            for (j = 0; j < size; j++) {
+               re = bre[j] * bre[j] - bim[j] * bim[j];
+               im = 2.0 * bre[j] * bim[j];
+               bre[j] = re, bim[j] = im;
+            }
+      }
 
-   return complexes_transform(result, output_form);
+      if (n < 0)
+         for (j = 0; j < size; j++) {
+            denom = 1.0 / (pre[j] * pre[j] + pim[j] * pim[j]);
+            pre[j] *= denom, pim[j] *= -denom;
+         }
+
+      for (j = 0; j < size; j++)
+         rre[i+j] = pre[j], rim[i+j] = pim[j];
+   }
 }
 
 /**
- * Get the conjugate of `complex` number. The result complex number 
- * will be in form of `output_form` and must be `cartesian` or `polar`.
+ * Run the `kernel` over all elements of `result`. Large arrays are split
+ * into chunks spread across threads (when built with OpenMP).
  */
-complex_t complexes_conjugate(complex_t complex, str_t output_form)
+static void complexes_carray_run(carray_kernel_t kernel, carray_t *result,
+                                 const carray_t *farray, const carray_t *sarray,
+                                 int n)
 {
-    complex_t result;
+   long chunk, chunks;
+
+   if (result->size != farray->size || 
+       (sarray != NULL && sarray->size != farray->size))
+      alat_error("Dimension dismatch found");
 
-   result = complexes_zero("cartesian");
+   chunks = (long) ((result->size + 16383) / 16384);
 
-   result.complex[0] = complexes_transform(complex, "cartesian").complex[0];
-   result.complex[1] = -1 * complexes_transform(complex, "cartesian").complex[1];
+   #pragma omp parallel for if (chunks > 4)
+   for (chunk = 0; chunk < chunks; chunk++) {
+      size_t start = chunk * 16384;
+      size_t end = (start + 16384 > result->size) ? result->size : start + 16384;
 
-   return complexes_transform(result, output_form);
+      kernel(result, farray, sarray, start, end, n);
+   }
 }
 
 /**
- * Get the reciprocol of `complex` number. The result complex number 
- * will be in form of `output_form` and must be `cartesian` or `polar`.
+ * Add up the complex arrays `farray` and `sarray` into `result`.
  */
-complex_t complexes_reciprocol(complex_t complex, str_t output_form)
+void complexes_carray_add(carray_t *result, const carray_t *farray, 
+                          const carray_t *sarray)
+{
+   complexes_carray_run(complexes_kadd, result, farray, sarray, 0);
+}
+
+/**
+ * Subtract the complex array `sarray` from `farray` into `result`.
+ */
+void complexes_carray_subtract(carray_t *result, const carray_t *farray, 
+                               const carray_t *sarray)
+{
+   complexes_carray_run(complexes_ksub, result, farray, sarray, 0);
+}
+
+/**
+ * Multiply the complex arrays `farray` and `sarray` into `result`.
+ */
+void complexes_carray_multiply(carray_t *result, const carray_t *farray, 
+                               const carray_t *sarray)
+{
+   complexes_carray_run(complexes_kmul, result, farray, sarray, 0);
+}
+
+/**
+ * Divide the complex array `farray` by `sarray` into `result`.
+ */
+void complexes_carray_divide(carray_t *result, const carray_t *farray, 
+                             const carray_t *sarray)
 {
-   return complexes_power(complex, -1, output_form);
+   complexes_carray_run(complexes_kdiv, result, farray, sarray, 0);
+}
+
+/**
+ * Get the conjugate of complex `array` into `result`.
+ */
+void complexes_carray_conjugate(carray_t *result, const carray_t *array)
+{
+   complexes_carray_run(complexes_kconj, result, array, NULL, 0);
+}
+
+/**
+ * Get the reciprocol of complex `array` into `result`.
+ */
+void complexes_carray_reciprocol(carray_t *result, const carray_t *array)
+{
+   complexes_carray_run(complexes_krecip, result, array, NULL, 0);
+}
+
+/**
+ * Get the `n`.th integer power of complex `array` into `result` using
+ * repeated squaring (no trigonometry).
+ */
+void complexes_carray_power(carray_t *result, const carray_t *array, int n)
+{
+   complexes_carray_run(complexes_kpowi, result, array, NULL, n);
+}
+
+/**
+ * Get all `n` of `n`.th roots of each element of complex `array` into 
+ * `result` which must have `n` times size of `array` elements. The k.th
+ * root of i.th element is placed at i * n + k. The roots of unity are 
+ * calculated once and each principal root is rotated by them.
+ */
+void complexes_carray_roots(carray_t *result, const carray_t *array, int n)
+{
+   cnum_t *unity, root;
+   size_t i;
+   int k;
+
+   if (n < 1)
+      alat_error("'n' must be positive");
+   if (result->size != array->size * n)
+      alat_error("Dimension dismatch found");
+
+   unity = malloc(sizeof(cnum_t) * n);
+   if (unity == NULL)
+      alat_error("Memory allocation failed");
+   complexes_croots(complexes_cnum(1.0, 0.0), n, unity);
+
+   #pragma omp parallel for private(root, k) if (array->size > 4096)
+   for (i = 0; i < array->size; i++) {
+      double *rre = result->re + i * n, *rim = result->im + i * n;
+
+      root = complexes_croot(complexes_cnum(array->re[i], array->im[i]), n);
+      for (k = 0; k < n; k++) {
+         rre[k] = root.re * unity[k].re - root.im * unity[k].im;
+         rim[k] = root.re * unity[k].im + root.im * unity[k].re;
+      }
+   }
+
+   free(unity);
+}
+
+/**
+ * Get the modules of complex `array` into `result` which must have
+ * size of `array` elements.
+ */
+void complexes_carray_modules(double *result, const carray_t *array)
+{
+   carray_t output = {array->size, result, NULL};
+
+   complexes_carray_run(complexes_kabs, &output, array, NULL, 0);
+}
+
+/**
+ * Get the arguments (in degrees) of complex `array` into `result` 
+ * which must have size of `array` elements.
+ */
+void complexes_carray_argument(double *result, const carray_t *array)
+{
+   carray_t output = {array->size, result, NULL};
+
+   complexes_carray_run(complexes_karg, &output, array, NULL, 0);
+}
+
+/**
+ * Run the butterflies of power-of-two transform of `plan` in place on
+ * `re` and `im`. Radix-2 stages are merged in pairs into radix-4 passes
+ * whose twiddle factors are contiguous in `plan`.
+ */
+static ALAT_SIMD void complexes_fft_pow2(const fftplan_t *plan, double *re,
+                                         double *im, bool_t inverse)
+{
+   double a0re, a0im, a1re, a1im, a2re, a2im, a3re, a3im, t1re, t1im, t3re,
+          t3im, u2re, u2im, u3re, u3im, wre, wim, w1re, w1im, temp, sign;
+   size_t i, j, g, h, n;
+
+   n = plan->size;
+   sign = (inverse) ? -1.0 : 1.0;
+
+   // Reorder the elements in bit reversal order.
+   for (i = 0; i < n; i++) {
+      j = plan->bitrev[i];
+      if (i < j)
+         temp = re[i], re[i] = re[j], re[j] = temp,
+         temp = im[i], im[i] = im[j], im[j] = temp;
+   }
+
+   h = 1;
+
+   // Apply single radix-2 pass if count of stages is odd.
+   if (plan->odd) {
+      for (i = 0; i < n; i += 2) {
+         a0re = re[i], a0im = im[i], a1re = re[i+1], a1im = im[i+1];
+         re[i] = a0re + a1re, im[i] = a0im + a1im;
+         re[i+1] = a0re - a1re, im[i+1] = a0im - a1im;
+      }
+      h = 2;
+   }
+
+   for (; h < n; h *= 4) {
+      for (g = 0; g < n; g += 4 * h) {
+         double *x0re = re + g, *x1re = re + g + h, *x2re = re + g + 2*h, 
+                *x3re = re + g + 3*h;
+         double *x0im = im + g, *x1im = im + g + h, *x2im = im + g + 2*h, 
+                *x3im = im + g + 3*h;
+
+         for (j = 0; j < h; j++) {
+            wre = plan->twre[h+j], wim = sign * plan->twim[h+j];
+            w1re = plan->tw2re[h+j], w1im = sign * plan->tw2im[h+j];
+
+            a0re = x0re[j], a0im = x0im[j], a1re = x1re[j], a1im = x1im[j];
+            a2re = x2re[j], a2im = x2im[j], a3re = x3re[j], a3im = x3im[j];
+
+            // First radix-2 stage which has span h.
+            t1re = w1re * a1re - w1im * a1im, t1im = w1re * a1im + w1im * a1re;
+            t3re = w1re * a3re - w1im * a3im, t3im = w1re * a3im + w1im * a3re;
+            a1re = a0re - t1re, a1im = a0im - t1im;
+            a0re = a0re + t1re, a0im = a0im + t1im;
+            a3re = a2re - t3re, a3im = a2im - t3im;
+            a2re = a2re + t3re, a2im = a2im + t3im;
+
+            // Second radix-2 stage which has span 2h.
+            u2re = wre * a2re - wim * a2im, u2im = wre * a2im + wim * a2re;
+            u3re = wre * a3re - wim * a3im, u3im = wre * a3im + wim * a3re;
+            x0re[j] = a0re + u2re, x0im[j] = a0im + u2im;
+            x2re[j] = a0re - u2re, x2im[j] = a0im - u2im;
+            x1re[j] = a1re + sign * u3im, x1im[j] = a1im - sign * u3re;
+            x3re[j] = a1re - sign * u3im, x3im[j] = a1im + sign * u3re;
+         }
+      }
+   }
+}
+
+/**
+ * Run the transform of `plan` in place on `re` and `im` without scaling.
+ * `sre` and `sim` are scratch arrays which have `plan->scratch` elements.
+ */
+static void complexes_fft_run(const fftplan_t *plan, double *re, double *im,
+                              double *sre, double *sim, bool_t inverse)
+{
+   double cre, cim, fre, fim, temp, sign;
+   size_t i, m;
+
+   if (plan->bitrev != NULL) {
+      complexes_fft_pow2(plan, re, im, inverse);
+      return;
+   }
+
+   // Apply Bluestein algorithm as convolution of chirped elements.
+   m = plan->inner->size;
+   sign = (inverse) ? -1.0 : 1.0;
+
+   for (i = 0; i < plan->size; i++) {
+      cre = plan->chirp.re[i], cim = sign * plan->chirp.im[i];
+      sre[i] = re[i] * cre - im[i] * cim;
+      sim[i] = re[i] * cim + im[i] * cre;
+   }
+   for (i = plan->size; i < m; i++)
+      sre[i] = 0.0, sim[i] = 0.0;
+
+   complexes_fft_pow2(plan->inner, sre, sim, false);
+
+   for (i = 0; i < m; i++) {
+      fre = plan->filter.re[i], fim = sign * plan->filter.im[i];
+      temp = sre[i] * fre - sim[i] * fim;
+      sim[i] = sre[i] * fim + sim[i] * fre, sre[i] = temp;
+   }
+
+   complexes_fft_pow2(plan->inner, sre, sim, true);
+
+   for (i = 0; i < plan->size; i++) {
+      cre = plan->chirp.re[i] / m, cim = sign * plan->chirp.im[i] / m;
+      re[i] = sre[i] * cre - sim[i] * cim;
+      im[i] = sre[i] * cim + sim[i] * cre;
+   }
+}
+
+/**
+ * Create the transform plan of `size` elements. Twiddle factors are 
+ * calculated once and stored in the plan. If `real` is true, the plan is
+ * for real-input transforms (`complexes_rfft`, `complexes_irfft`),
+ * otherwise for complex transforms (`complexes_fft`). Powers of two use
+ * radix-4 passes, other sizes use Bluestein algorithm.
+ */
+fftplan_t *complexes_fftplan(size_t size, bool_t real)
+{
+   fftplan_t *plan;
+   carray_t filter;
+   double angle;
+   size_t i, j, h, m, bits;
+
+   if (size == 0)
+      alat_error("'size' must be positive");
+
+   plan = calloc(1, sizeof(fftplan_t));
+   if (plan == NULL)
+      alat_error("Memory allocation failed");
+
+   plan->size = size, plan->real = real;
+
+   // Real transform of even size runs as complex transform of half
+   // size, odd size runs as complex transform of same size.
+   if (real) {
+      m = (size % 2 == 0) ? size / 2 : size;
+      plan->inner = complexes_fftplan(m, false);
+      plan->scratch = m + plan->inner->scratch;
+      plan->chirp = complexes_carray(m + 1);
+
+      for (i = 0; i <= m && size % 2 == 0; i++) {
+         angle = 2.0 * M_PI * i / size;
+         plan->chirp.re[i] = cos(angle), plan->chirp.im[i] = -sin(angle);
+      }
+      plan->work = complexes_carray(plan->scratch);
+      return plan;
+   }
+
+   if ((size & (size - 1)) == 0) {
+      for (bits = 0; ((size_t) 1 << bits) < size; bits++)
+         ;
+      plan->odd = bits % 2;
+      plan->bitrev = malloc(sizeof(size_t) * size);
+      plan->twre = malloc(sizeof(com_t) * size);
+      plan->twim = malloc(sizeof(com_t) * size);
+      plan->tw2re = malloc(sizeof(com_t) * size);
+      plan->tw2im = malloc(sizeof(com_t) * size);
+      if (plan->bitrev == NULL || plan->twre == NULL || plan->twim == NULL ||
+          plan->tw2re == NULL || plan->tw2im == NULL)
+         alat_error("Memory allocation failed");
+
+      for (i = 0; i < size; i++) {
+         for (j = 0, h = 0; h < bits; h++)
+            j |= ((i >> h) & 1) << (bits - 1 - h);
+         plan->bitrev[i] = j;
+      }
+      // Twiddle factors of pass which has span h are in [h, 2h).
+      for (h = (plan->odd) ? 2 : 1; h < size; h *= 4) {
+         for (j = 0; j < h; j++) {
+            angle = 2.0 * M_PI * j / (4 * h);
+            plan->twre[h+j] = cos(angle), plan->twim[h+j] = -sin(angle);
+            angle = 2.0 * M_PI * j / (2 * h);
+            plan->tw2re[h+j] = cos(angle), plan->tw2im[h+j] = -sin(angle);
+         }
+      }
+      plan->work = complexes_carray(0);
+      return plan;
+   }
+
+   // Prepare the chirp and transformed filter of Bluestein algorithm.
+   for (m = 1; m < 2 * size - 1; m *= 2)
+      ;
+   plan->inner = complexes_fftplan(m, false);
+   plan->scratch = m;
+   plan->chirp = complexes_carray(size);
+   filter = complexes_carray(m);
+
+   for (i = 0; i < size; i++) {
+      angle = M_PI * (double) ((i * i) % (2 * size)) / size;
+      plan->chirp.re[i] = cos(angle), plan->chirp.im[i] = -sin(angle);
+      filter.re[i] = cos(angle), filter.im[i] = sin(angle);
+      if (i > 0)
+         filter.re[m-i] = cos(angle), filter.im[m-i] = sin(angle);
+   }
+   complexes_fft_pow2(plan->inner, filter.re, filter.im, false);
+   plan->filter = filter;
+   plan->work = complexes_carray(plan->scratch);
+
+   return plan;
+}
+
+/**
+ * Release the memory of transform `plan`.
+ */
+void complexes_fftplan_free(fftplan_t *plan)
+{
+   if (plan == NULL)
+      return;
+
+   free(plan->bitrev);
+   free(plan->twre), free(plan->twim), free(plan->tw2re), free(plan->tw2im);
+   if (plan->chirp.re != NULL)
+      complexes_carray_free(&plan->chirp);
+   if (plan->filter.re != NULL)
+      complexes_carray_free(&plan->filter);
+   if (plan->work.re != NULL)
+      complexes_carray_free(&plan->work);
+   complexes_fftplan_free(plan->inner);
+   free(plan);
+}
+
+/**
+ * Apply the discrete Fourier transform of `plan` on complex `array` and 
+ * write it into `result`. If `inverse` is true, apply the inverse 
+ * transform scaled by 1/n. `result` can be same as `array`.
+ */
+void complexes_fft(fftplan_t *plan, carray_t *result, const carray_t *array,
+                   bool_t inverse)
+{
+   size_t i;
+
+   if (plan->real)
+      alat_error("Plan is for real-input transform");
+   if (array->size != plan->size || result->size != plan->size)
+      alat_error("Dimension dismatch found");
+
+   if (result->re != array->re) {
+      memcpy(result->re, array->re, sizeof(com_t) * plan->size);
+      memcpy(result->im, array->im, sizeof(com_t) * plan->size);
+   }
+
+   complexes_fft_run(plan, result->re, result->im, plan->work.re, 
+                     plan->work.im, inverse);
+
+   if (inverse)
+      for (i = 0; i < plan->size; i++)
+         result->re[i] /= plan->size, result->im[i] /= plan->size;
+}
+
+/**
+ * Apply the discrete Fourier transform of real-input `plan` on `input`
+ * which has n elements and write the n/2+1 non-redundant elements of
+ * the transform into `result`.
+ */
+void complexes_rfft(fftplan_t *plan, carray_t *result, const double *input)
+{
+   const fftplan_t *inner;
+   double *zre, *zim, ere, eim, ore, oim, wre, wim;
+   size_t i, m;
+
+   if (!plan->real)
+      alat_error("Plan is for complex transform");
+   if (result->size != plan->size / 2 + 1)
+      alat_error("Dimension dismatch found");
+
+   inner = plan->inner, m = inner->size;
+   zre = plan->work.re, zim = plan->work.im;
+
+   if (plan->size % 2 == 1) {
+      for (i = 0; i < m; i++)
+         zre[i] = input[i], zim[i] = 0.0;
+      complexes_fft_run(inner, zre, zim, zre + m, zim + m, false);
+      memcpy(result->re, zre, sizeof(com_t) * result->size);
+      memcpy(result->im, zim, sizeof(com_t) * result->size);
+      return;
+   }
+
+   // Pack even and odd elements into half size complex transform.
+   for (i = 0; i < m; i++)
+      zre[i] = input[2*i], zim[i] = input[2*i+1];
+   complexes_fft_run(inner, zre, zim, zre + m, zim + m, false);
+
+   // Split the transform into even and odd portions and combine them.
+   for (i = 0; i <= m; i++) {
+      size_t k = i % m, l = (m - i) % m;
+
+      ere = (zre[k] + zre[l]) / 2, eim = (zim[k] - zim[l]) / 2;
+      ore = (zim[k] + zim[l]) / 2, oim = (zre[l] - zre[k]) / 2;
+      wre = plan->chirp.re[i], wim = plan->chirp.im[i];
+
+      result->re[i] = ere + wre * ore - wim * oim;
+      result->im[i] = eim + wre * oim + wim * ore;
+   }
+}
+
+/**
+ * Apply the inverse discrete Fourier transform of real-input `plan` on
+ * n/2+1 non-redundant elements of `array` and write the n real elements
+ * into `result`.
+ */
+void complexes_irfft(fftplan_t *plan, double *result, const carray_t *array)
+{
+   const fftplan_t *inner;
+   double *zre, *zim, ere, eim, dre, dim, ore, oim, wre, wim;
+   size_t i, m;
+
+   if (!plan->real)
+      alat_error("Plan is for complex transform");
+   if (array->size != plan->size / 2 + 1)
+      alat_error("Dimension dismatch found");
+
+   inner = plan->inner, m = inner->size;
+   zre = plan->work.re, zim = plan->work.im;
+
+   if (plan->size % 2 == 1) {
+      // Rebuild the full transform using Hermitian symmetry.
+      for (i = 0; i < m; i++) {
+         if (i < array->size)
+            zre[i] = array->re[i], zim[i] = array->im[i];
+         else
+            zre[i] = array->re[m-i], zim[i] = -array->im[m-i];
+      }
+      complexes_fft_run(inner, zre, zim, zre + m, zim + m, true);
+      for (i = 0; i < m; i++)
+         result[i] = zre[i] / m;
+      return;
+   }
+
+   for (i = 0; i < m; i++) {
+      ere = (array->re[i] + array->re[m-i]) / 2;
+      eim = (array->im[i] - array->im[m-i]) / 2;
+      dre = (array->re[i] - array->re[m-i]) / 2;
+      dim = (array->im[i] + array->im[m-i]) / 2;
+      wre = plan->chirp.re[i], wim = -plan->chirp.im[i];
+      ore = dre * wre - dim * wim, oim = dre * wim + dim * wre;
+
+      zre[i] = ere - oim, zim[i] = eim + ore;
+   }
+   complexes_fft_run(inner, zre, zim, zre + m, zim + m, true);
+
+   for (i = 0; i < m; i++)
+      result[2*i] = zre[i] / m, result[2*i+1] = zim[i] / m;
+}
+
+/**
+ * Apply the two dimensional discrete Fourier transform on `array` which
+ * holds `rows` x `cols` row-major elements and write it into `result`.
+ * If `inverse` is true, apply the inverse transform scaled by 1/(rows *
+ * cols). Rows and then columns are spread across threads (when built 
+ * with OpenMP).
+ */
+void complexes_fft2(carray_t *result, const carray_t *array, size_t rows,
+                    size_t cols, bool_t inverse)
+{
+   fftplan_t *rplan, *cplan;
+   long r, c;
+
+   if (array->size != rows * cols || result->size != rows * cols)
+      alat_error("Dimension dismatch found");
+
+   if (result->re != array->re) {
+      memcpy(result->re, array->re, sizeof(com_t) * array->size);
+      memcpy(result->im, array->im, sizeof(com_t) * array->size);
+   }
+
+   rplan = complexes_fftplan(cols, false);
+   cplan = complexes_fftplan(rows, false);
+
+   #pragma omp parallel
+   {
+      carray_t scratch = complexes_carray(rows + cols + rplan->scratch + 
+                                          cplan->scratch);
+      size_t i;
+
+      #pragma omp for
+      for (r = 0; r < (long) rows; r++)
+         complexes_fft_run(rplan, result->re + r * cols, result->im + r * cols,
+                           scratch.re, scratch.im, inverse);
+
+      #pragma omp for
+      for (c = 0; c < (long) cols; c++) {
+         double *cre = scratch.re + cplan->scratch;
+         double *cim = scratch.im + cplan->scratch;
+
+         for (i = 0; i < rows; i++)
+            cre[i] = result->re[i*cols+c], cim[i] = result->im[i*cols+c];
+         complexes_fft_run(cplan, cre, cim, scratch.re, scratch.im, inverse);
+         for (i = 0; i < rows; i++)
+            result->re[i*cols+c] = cre[i], result->im[i*cols+c] = cim[i];
+      }
+
+      complexes_carray_free(&scratch);
+   }
+
+   if (inverse)
+      for (r = 0; r < (long) (rows * cols); r++)
+         result->re[r] /= rows * cols, result->im[r] /= rows * cols;
+
+   complexes_fftplan_free(rplan);
+   complexes_fftplan_free(cplan);
 }
@@ -12,6 +12,8 @@ matrix_t crypts_to_matrix(str_t message, shape_t shape)
 
    if (shape.row != shape.col)
       alat_error("Sqaure matrix error");
+   if (strlen(message) > shape.row * shape.col)
+      alat_error("Message is longer than the encoder block");
    
    index = 0; i = 0; j = 0;
    result = matrices_arbitrary(-1.0, shape);
@@ -27,6 +29,64 @@ matrix_t crypts_to_matrix(str_t message, shape_t shape)
    return result;
 }
 
+/**
+ * Encode the `message` using precomputed `key`.
+ */
+matrix_t crypts_key_encode(const crypts_key_t *key, str_t message)
+{
+   return matrices_cross_mul(crypts_to_matrix(message, 
+      key->encoder.shape), key->encoder);
+}
+
+/**
+ * Decode the `encoded` matrix using precomputed `key`.
+ */
+matrix_t crypts_key_decode(const crypts_key_t *key, matrix_t encoded)
+{
+   if (key->modulus != 0)
+      alat_error("Modular key has no decoder matrix");
+
+   return matrices_cross_mul(encoded, key->decoder);
+}
+
+/**
+ * Convert the `decoded` matrix into message, skipping -1 paddings.
+ */
+static str_t crypts_from_matrix(matrix_t decoded)
+{
+   str_t message;
+   int index, i, j, lenght;
+
+   index = 0; lenght = 0;
+
+   for (i = 0; i < decoded.shape.row; i++) 
+      for (j = 0; j < decoded.shape.col; j++) 
+         if (lround(decoded.matrix[i][j]) != -1)
+            lenght ++;
+
+   message = malloc(sizeof(char) * (lenght + 1));
+   if (message == NULL)
+      alat_error("Memory allocation failed");
+
+   for (i = 0; i < decoded.shape.row; i++) 
+      for (j = 0; j < decoded.shape.col; j++) 
+         if (lround(decoded.matrix[i][j]) != -1) 
+            message[index] = (char) lround(decoded.matrix[i][j]),
+            index ++;
+   message[index] = '\0';
+
+   return message;
+}
+
+/**
+ * Convert the `encoded` matrix back to original message using 
+ * precomputed `key`.
+ */
+str_t crypts_key_to_message(const crypts_key_t *key, matrix_t encoded)
+{
+   return crypts_from_matrix(crypts_key_decode(key, encoded));
+}
+
 /**
  * Encode the `message` using `encoder`. Note that `encoder`
  * must be invertible.
@@ -62,30 +122,486 @@ matrix_t crypts_decode(matrix_t encoded, matrix_t encoder)
  */
 str_t crypts_to_message(matrix_t encoded, matrix_t encoder)
 {
-   str_t message;
-   matrix_t decoded;
-   int index, i, j, lenght;
+   return crypts_from_matrix(crypts_decode(encoded, encoder));
+}
+
+/**
+ * Find the inverse of `value` in modulo `modulus`. Return 0, if `value`
+ * has no inverse (it is not coprime to `modulus`).
+ */
+static unsigned int crypts_mod_inverse(unsigned int value, unsigned int modulus)
+{
+   long long r, new_r, t, new_t, q, temp;
+
+   r = modulus, new_r = value % modulus;
+   t = 0, new_t = 1;
+
+   // Apply the extended Euclidean algorithm.
+   while (new_r != 0) {
+      q = r / new_r;
+      temp = t - q * new_t, t = new_t, new_t = temp;
+      temp = r - q * new_r, r = new_r, new_r = temp;
+   }
+   if (r != 1)
+      return 0;
+
+   return (unsigned int) ((t < 0) ? t + modulus : t);
+}
+
+/**
+ * Create the cryptography key from `encoder` matrix which must be
+ * invertible. The determinant and inverse of `encoder` are calculated
+ * once and stored in the key. For integer encoders, the inverse is rounded
+ * to multiples of 1 / determinant, which is exact while determinant times
+ * elements of the inverse (the integer adjoint) stays well below 2^53.
+ */
+crypts_key_t crypts_key(matrix_t encoder)
+{
+   crypts_key_t key;
 
    if (!matrices_issquare(encoder))
       alat_error("Square matrix error");
-   if (!matrices_isinvertible(encoder))
+
+   key.dim = encoder.shape.row, key.modulus = 0;
+   key.det = matrices_det(encoder);
+
+   if (key.det == 0.0)
       alat_error("Non-invertible matrix found");
 
-   index = 0; lenght = 0;
-   decoded = crypts_decode(encoded, encoder);
+   key.encoder = encoder;
+   key.decoder = matrices_inverse(encoder);
 
-   for (i = 0; i < decoded.shape.row; i++) 
-      for (j = 0; j < decoded.shape.col; j++) 
-         if ((int) (float) decoded.matrix[i][j] != -1)
-            lenght ++;
+   return key;
+}
 
-   message = malloc(sizeof(char) * lenght);
+/**
+ * Create the cryptography key from integer `encoder` matrix for modular
+ * arithmetic in modulo `modulus`, which must be between 2 and 256 (256 or a
+ * prime is recommended). Data bytes must be residues in [0, modulus), so
+ * a prime below 256 such as 251 can't encode every byte value. `modulus`
+ * must be greater than block size, since padding bytes are counts up to
+ * block size, and `encoder` must be invertible in modulo `modulus`. Only
+ * modular tables are calculated, so determinant and decoder of the key are
+ * left zero. If `modulus` is 0, the key is created by crypts_key.
+ */
+crypts_key_t crypts_modkey(matrix_t encoder, unsigned int modulus)
+{
+   crypts_key_t key;
+   long long *array, temp, coef;
+   unsigned int inverse;
+   int i, j, k, n, width, pivot;
 
-   for (i = 0; i < decoded.shape.row; i++) 
-      for (j = 0; j < decoded.shape.col; j++) 
-         if ((int) (float) decoded.matrix[i][j] != -1) 
-            message[index] = (char)(int)(float) decoded.matrix[i][j],
-            index ++;
+   if (modulus == 0)
+      return crypts_key(encoder);
 
-   return message;
+   if (!matrices_issquare(encoder))
+      alat_error("Square matrix error");
+   if (!matrices_isinteger(encoder))
+      alat_error("Encoder must contain integers");
+   if (modulus < 2 || modulus > 256)
+      alat_error("'modulus' must be between 2 and 256");
+
+   n = encoder.shape.row, width = 2 * n;
+   if (modulus <= (unsigned int) n)
+      alat_error("'modulus' must be greater than block size");
+
+   key.dim = n, key.modulus = modulus, key.det = 0.0;
+   key.encoder = encoder;
+   key.decoder = matrices_zeros(encoder.shape);
+
+   array = malloc(sizeof(long long) * n * width);
+   if (array == NULL)
+      alat_error("Memory allocation failed");
+
+   // Reduce the 'encoder' into modulo and augment it with identity.
+   for (i = 0; i < n; i++) {
+      for (j = 0; j < n; j++) {
+         temp = (long long) encoder.matrix[i][j] % (long long) modulus;
+         array[i*width+j] = (temp < 0) ? temp + modulus : temp;
+         array[i*width+j+n] = (i == j) ? 1 : 0;
+         key.modencoder[i][j] = (unsigned short) array[i*width+j];
+      }
+   }
+
+   // Apply Gauss-Jordan elimination using pivots invertible in modulo.
+   for (k = 0; k < n; k++) {
+      inverse = 0;
+      for (pivot = k; pivot < n; pivot++)
+         if ((inverse = crypts_mod_inverse(array[pivot*width+k],
+                                           modulus)) != 0)
+            break;
+      if (inverse == 0)
+         alat_error("Non-invertible matrix found in modulo");
+
+      // Move the pivot row to k.th row and normalize it.
+      for (j = 0; j < width; j++)
+         temp = array[k*width+j], array[k*width+j] = array[pivot*width+j],
+         array[pivot*width+j] = temp;
+      for (j = 0; j < width; j++)
+         array[k*width+j] = (array[k*width+j] * inverse) % modulus;
+
+      for (i = 0; i < n; i++) {
+         if (i == k || array[i*width+k] == 0)
+            continue;
+         coef = array[i*width+k];
+         for (j = 0; j < width; j++)
+            array[i*width+j] = ((array[i*width+j] - coef * array[k*width+j])
+                                % modulus + modulus) % modulus;
+      }
+   }
+
+   for (i = 0; i < n; i++)
+      for (j = 0; j < n; j++)
+         key.moddecoder[i][j] = (unsigned short) array[i*width+j+n];
+
+   free(array);
+   return key;
+}
+
+/**
+ * Multiply each `blocks` blocks of `input` (as row vectors) with `table`
+ * in modulo `modulus` and write them into `output`.
+ */
+static ALAT_SIMD void crypts_mod_blocks(const unsigned short table[ROW][COL],
+                                        dim_t dim, unsigned int modulus, 
+                                        const unsigned char *input,
+                                        unsigned char *output, size_t blocks)
+{
+   unsigned int total[COL];
+   unsigned short wrapped[COL];
+   size_t b;
+   int j, k;
+
+   // In modulo 256, 16-bit sums wrap around and keep the low byte
+   // correct, so twice as many columns fit in each vector.
+   if (modulus == 256) {
+      for (b = 0; b < blocks; b++, input += dim, output += dim) {
+         for (j = 0; j < dim; j++)
+            wrapped[j] = 0;
+         for (k = 0; k < dim; k++)
+            for (j = 0; j < dim; j++)
+               wrapped[j] += (unsigned short) (input[k] * table[k][j]);
+         for (j = 0; j < dim; j++)
+            output[j] = (unsigned char) wrapped[j];
+      }
+      return;
+   }
+
+   for (b = 0; b < blocks; b++, input += dim, output += dim) {
+      for (j = 0; j < dim; j++)
+         total[j] = 0;
+      for (k = 0; k < dim; k++)
+         for (j = 0; j < dim; j++)
+            total[j] += input[k] * table[k][j];
+      for (j = 0; j < dim; j++)
+         output[j] = (unsigned char) (total[j] % modulus);
+   }
+}
+
+/**
+ * Return the size of encoded buffer of `lenght` bytes using `key`. The
+ * last block is always padded, so the size is the next multiple of
+ * block size.
+ */
+size_t crypts_mod_size(const crypts_key_t *key, size_t lenght)
+{
+   return (lenght / key->dim + 1) * key->dim;
+}
+
+/**
+ * Multiply `blocks` blocks of `input` with encoder or decoder of `key`
+ * according to `decode` as one batch. If `threads` is more than one, 
+ * the batch is spread across threads (when built with OpenMP).
+ */
+static void crypts_mod_batch(const crypts_key_t *key, bool_t decode, 
+                             const unsigned char *input, unsigned char *output,
+                             size_t blocks, int threads)
+{
+   const unsigned short (*table)[COL];
+   size_t i, step;
+   long t;
+
+   table = (decode) ? key->moddecoder : key->modencoder;
+
+   if (!decode && key->modulus < 256)
+      for (i = 0; i < blocks * key->dim; i++)
+         if (input[i] >= key->modulus)
+            alat_error("Data byte exceeds the modulus");
+
+   if (threads < 2 || blocks < 1024) {
+      crypts_mod_blocks(table, key->dim, key->modulus, input, output, blocks);
+      return;
+   }
+
+   step = (blocks + threads - 1) / threads;
+
+   #pragma omp parallel for num_threads(threads)
+   for (t = 0; t < threads; t++) {
+      size_t start = t * step;
+      size_t count = (start + step > blocks) ? blocks - start : step;
+
+      if (start < blocks)
+         crypts_mod_blocks(table, key->dim, key->modulus, 
+                           input + start * key->dim, output + start * key->dim,
+                           count);
+   }
+}
+
+/**
+ * Initialize the cryptography `stream` with modular `key`. `decode` 
+ * indicates the direction of stream and `threads` is the count of
+ * threads used for large chunks. `key` must live as long as `stream`.
+ */
+void crypts_stream_init(crypts_stream_t *stream, const crypts_key_t *key,
+                        bool_t decode, int threads)
+{
+   if (decode != true && decode != false)
+      alat_error("'decode' must be true or false");
+   if (key->modulus == 0)
+      alat_error("Key has no modulus");
+   if (key->modulus <= key->dim)
+      alat_error("'modulus' must be greater than block size");
+
+   stream->key = key;
+   stream->decode = decode;
+   stream->threads = (threads < 1) ? 1 : threads;
+   stream->pending = 0;
+}
+
+/**
+ * Feed `lenght` bytes of `input` into `stream`. All complete blocks are
+ * processed as one batch and written into `output` which must have 
+ * `lenght` plus block size bytes. Return the count of written bytes.
+ */
+size_t crypts_stream_update(crypts_stream_t *stream, const unsigned char *input,
+                            size_t lenght, unsigned char *output)
+{
+   size_t total, blocks, used, written;
+   dim_t dim;
+
+   dim = stream->key->dim;
+   total = stream->pending + lenght;
+
+   // While decoding, the last block is kept back to remove its padding.
+   if (stream->decode)
+      blocks = (total == 0) ? 0 : (total - 1) / dim;
+   else
+      blocks = total / dim;
+
+   if (blocks == 0) {
+      memcpy(stream->buffer + stream->pending, input, lenght);
+      stream->pending += lenght;
+      return 0;
+   }
+
+   written = 0;
+
+   // Complete the pending block using the head of 'input'.
+   if (stream->pending > 0) {
+      used = dim - stream->pending;
+      memcpy(stream->buffer + stream->pending, input, used);
+      input += used, lenght -= used;
+
+      crypts_mod_batch(stream->key, stream->decode, stream->buffer, 
+                       output, 1, 1);
+      output += dim, written += dim;
+      blocks --, stream->pending = 0;
+   }
+
+   crypts_mod_batch(stream->key, stream->decode, input, output, blocks, 
+                    stream->threads);
+   input += blocks * dim, lenght -= blocks * dim;
+   written += blocks * dim;
+
+   memcpy(stream->buffer, input, lenght);
+   stream->pending = lenght;
+
+   return written;
+}
+
+/**
+ * Finish the `stream` and write its last block into `output` which must
+ * have block size bytes. While encoding, the last block is padded with
+ * the count of padding bytes (1 to block size, so it is a residue of any
+ * accepted modulus). While decoding, that padding is checked byte by byte
+ * and removed. Return the count of written bytes.
+ */
+size_t crypts_stream_final(crypts_stream_t *stream, unsigned char *output)
+{
+   size_t pad, i;
+   dim_t dim;
+
+   dim = stream->key->dim;
+
+   if (!stream->decode) {
+      memset(stream->buffer + stream->pending, (int) (dim - stream->pending),
+             dim - stream->pending);
+      crypts_mod_batch(stream->key, false, stream->buffer, output, 1, 1);
+      stream->pending = 0;
+      return dim;
+   }
+
+   if (stream->pending != dim)
+      alat_error("Encoded size must be multiple of block size");
+
+   crypts_mod_batch(stream->key, true, stream->buffer, output, 1, 1);
+   stream->pending = 0;
+
+   // Every padding byte must hold the count, so corrupted blocks are found.
+   pad = output[dim-1];
+   if (pad == 0 || pad > dim)
+      alat_error("Invalid padding found");
+   for (i = dim - pad; i < dim; i++)
+      if (output[i] != pad)
+         alat_error("Invalid padding found");
+
+   return dim - pad;
+}
+
+/**
+ * Encode `lenght` bytes of `data` into `encoded` using modular `key`.
+ * `encoded` must have `crypts_mod_size` bytes. Each byte of `data` must be
+ * a residue in [0, modulus), so bytes aren't remapped and larger ones are
+ * refused when modulus is below 256. The last block is padded with the
+ * count of padding bytes. Return the encoded size.
+ */
+size_t crypts_mod_encode(const crypts_key_t *key, const unsigned char *data,
+                         size_t lenght, unsigned char *encoded)
+{
+   crypts_stream_t stream;
+   size_t written;
+
+   crypts_stream_init(&stream, key, false, 1);
+   written = crypts_stream_update(&stream, data, lenght, encoded);
+
+   return written + crypts_stream_final(&stream, encoded + written);
+}
+
+/**
+ * Decode `lenght` bytes of `encoded` into `data` using modular `key`.
+ * `data` must have `lenght` bytes. Return the size of original data
+ * after removing the padding, and refuse `encoded` whose padding bytes
+ * don't all hold the padding count.
+ */
+size_t crypts_mod_decode(const crypts_key_t *key, const unsigned char *encoded,
+                         size_t lenght, unsigned char *data)
+{
+   crypts_stream_t stream;
+   size_t written;
+
+   if (lenght == 0 || lenght % key->dim != 0)
+      alat_error("Encoded size must be multiple of block size");
+
+   crypts_stream_init(&stream, key, true, 1);
+   written = crypts_stream_update(&stream, encoded, lenght, data);
+
+   return written + crypts_stream_final(&stream, data + written);
+}
+
+/**
+ * Multiply `rows` x `dim` row-major `input` with `table` matrix and write
+ * the product into `output`. Rows are processed in blocks so that a block
+ * of `output` and `table` stay in cache together. Blocks are shared
+ * between threads only when the product is large enough to pay for them.
+ */
+static void crypts_gemm(const double *input, size_t rows, dim_t dim,
+                        const matrix_t *table, double *output)
+{
+   long block;
+
+   #pragma omp parallel for if (rows * dim * dim >= 65536)
+   for (block = 0; block < (long) ((rows + 63) / 64); block++) {
+      size_t i, end;
+      int j, k;
+
+      end = (block + 1) * 64;
+      if (end > rows)
+         end = rows;
+
+      for (i = block * 64; i < end; i++) {
+         for (j = 0; j < dim; j++)
+            output[i*dim+j] = 0.0;
+         for (k = 0; k < dim; k++)
+            for (j = 0; j < dim; j++)
+               output[i*dim+j] += input[i*dim+k] * table->matrix[k][j];
+      }
+   }
+}
+
+/**
+ * Encode `count` `messages` using precomputed `key` in one multiply. Each
+ * message is packed into consecutive rows of a tall matrix with block
+ * size columns, and its last row is padded with -1. `offsets` must have
+ * `count` + 1 elements and receives the first row of each message (the
+ * last one is total row count). Return the row-major encoded rows, which
+ * must be freed by caller.
+ */
+double *crypts_batch_encode(const crypts_key_t *key, size_t count, 
+                            str_t messages[], size_t offsets[])
+{
+   double *packed, *encoded;
+   size_t i, j, rows, lenght;
+
+   // Find the first row of each message.
+   rows = 0;
+   for (i = 0; i < count; i++)
+      offsets[i] = rows, rows += (strlen(messages[i]) + key->dim) / key->dim;
+   offsets[count] = rows;
+
+   packed = malloc(sizeof(double) * rows * key->dim);
+   encoded = malloc(sizeof(double) * rows * key->dim);
+   if (packed == NULL || encoded == NULL)
+      alat_error("Memory allocation failed");
+
+   for (i = 0; i < count; i++) {
+      lenght = strlen(messages[i]);
+      for (j = 0; j < (offsets[i+1] - offsets[i]) * key->dim; j++)
+         packed[offsets[i]*key->dim+j] = (j < lenght) ? 
+            (double) ((int) messages[i][j]) : -1.0;
+   }
+
+   crypts_gemm(packed, rows, key->dim, &key->encoder, encoded);
+   free(packed);
+
+   return encoded;
+}
+
+/**
+ * Convert `count` messages in `encoded` rows back to original messages 
+ * using precomputed `key` in one multiply. `offsets` are the first rows 
+ * of messages obtained by `crypts_batch_encode`. Each message is written
+ * into `messages` and must be freed by caller.
+ */
+void crypts_batch_to_messages(const crypts_key_t *key, size_t count,
+                              const double *encoded, const size_t offsets[],
+                              str_t messages[])
+{
+   double *decoded;
+   size_t i, j, lenght;
+
+   if (key->modulus != 0)
+      alat_error("Modular key has no decoder matrix");
+
+   decoded = malloc(sizeof(double) * offsets[count] * key->dim);
+   if (decoded == NULL)
+      alat_error("Memory allocation failed");
+
+   crypts_gemm(encoded, offsets[count], key->dim, &key->decoder, decoded);
+
+   for (i = 0; i < count; i++) {
+      lenght = (offsets[i+1] - offsets[i]) * key->dim;
+
+      messages[i] = malloc(sizeof(char) * (lenght + 1));
+      if (messages[i] == NULL)
+         alat_error("Memory allocation failed");
+
+      for (j = 0; j < lenght; j++) {
+         if (lround(decoded[offsets[i]*key->dim+j]) == -1)
+            break;
+         messages[i][j] = (char) lround(decoded[offsets[i]*key->dim+j]);
+      }
+      messages[i][j] = '\0';
+   }
+
+   free(decoded);
 }
@@ -0,0 +1,417 @@
+/* Elementwise math operations in ALAT (Advanced Linear Algebra Toolkit) */
+
+#include "./alat.h"
+
+/* Count of elements which math kernels process at once */
+#define MATHS_CHUNK     65536
+
+/* Largest integer exponent which fast mode multiplies by squaring */
+#define MATHS_POWI      4
+
+
+/* Accuracy mode of math methods, which is kept for each thread */
+static _Thread_local mathmode_t maths_mode = MATH_STRICT;
+
+typedef void (*maths_kernel_t)(double *fresult, double *sresult,
+                               const double *fx, const double *sx,
+                               double value, size_t n, mathmode_t mode);
+
+/**
+ * Set accuracy `mode` of math methods for calling thread. `MATH_STRICT` 
+ * calls libm for each element, and `MATH_FAST` uses vectorized polynomials
+ * in alat.h. Other threads keep their own modes, and threads which a call
+ * starts follow the mode of caller.
+ */
+void maths_set_mode(mathmode_t mode)
+{
+   if (mode != MATH_STRICT && mode != MATH_FAST)
+      alat_error("Math mode must be strict or fast");
+
+   maths_mode = mode;
+}
+
+/**
+ * Return the accuracy mode of math methods for calling thread.
+ */
+mathmode_t maths_get_mode(void)
+{
+   return maths_mode;
+}
+
+/* Run `kernel` on chunks of `n` elements, which are shared between threads
+   for large arrays. Mode of calling thread is passed to each chunk. */
+static void maths_run(maths_kernel_t kernel, double *fresult, double *sresult,
+                      const double *fx, const double *sx, double value,
+                      size_t n)
+{
+   mathmode_t mode = maths_mode;
+   long chunk;
+
+   #pragma omp parallel for if (n > 4 * MATHS_CHUNK)
+   for (chunk = 0; chunk < (long) ((n + MATHS_CHUNK - 1) / MATHS_CHUNK);
+        chunk++) {
+      size_t start = chunk * MATHS_CHUNK;
+      size_t size = (n - start < MATHS_CHUNK) ? n - start : MATHS_CHUNK;
+
+      kernel(fresult + start, (sresult != NULL) ? sresult + start : NULL,
+             fx + start, (sx != NULL) ? sx + start : NULL, value, size, 
+             mode);
+   }
+}
+
+static ALAT_SIMD void maths_ksqrt(double *fresult, double *sresult,
+                                  const double *fx, const double *sx,
+                                  double value, size_t n, mathmode_t mode)
+{
+   size_t i;
+
+   for (i = 0; i < n; i++)
+      fresult[i] = sqrt(fx[i]);
+}
+
+static ALAT_SIMD void maths_kcbrt(double *fresult, double *sresult,
+                                  const double *fx, const double *sx,
+                                  double value, size_t n, mathmode_t mode)
+{
+   size_t i;
+
+   if (mode == MATH_STRICT)
+      for (i = 0; i < n; i++)
+         fresult[i] = cbrt(fx[i]);
+   else
+      for (i = 0; i < n; i++)
+         fresult[i] = alat_cbrt(fx[i]);
+}
+
+static ALAT_SIMD void maths_kexp(double *fresult, double *sresult,
+                                 const double *fx, const double *sx,
+                                 double value, size_t n, mathmode_t mode)
+{
+   size_t i;
+
+   if (mode == MATH_STRICT)
+      for (i = 0; i < n; i++)
+         fresult[i] = exp(fx[i]);
+   else
+      for (i = 0; i < n; i++)
+         fresult[i] = alat_exp(fx[i]);
+}
+
+static ALAT_SIMD void maths_klog(double *fresult, double *sresult,
+                                 const double *fx, const double *sx,
+                                 double value, size_t n, mathmode_t mode)
+{
+   size_t i;
+
+   if (mode == MATH_STRICT)
+      for (i = 0; i < n; i++)
+         fresult[i] = log(fx[i]);
+   else
+      for (i = 0; i < n; i++)
+         fresult[i] = alat_log(fx[i]);
+}
+
+/* Multiply `x` and `y` exactly into `product` + `error` by Dekker's split,
+   which needs no fma instruction. */
+static inline void maths_mul2(double x, double y, double *product, 
+                              double *error)
+{
+   double xhigh, xlow, yhigh, ylow, t;
+
+   *product = x * y;
+   t = 134217729.0 * x, xhigh = t - (t - x), xlow = x - xhigh;
+   t = 134217729.0 * y, yhigh = t - (t - y), ylow = y - yhigh;
+   *error = ((xhigh * yhigh - *product) + xhigh * ylow + xlow * yhigh) + 
+            xlow * ylow;
+}
+
+/* Calculate the natural logarithm of positive `x` as double-double, which
+   returns high part and stores low part in `low`. With x = m * 2^e, 
+   log(m) is 2 * atanh(s) for s = (m - 1) / (m + 1), whose leading 2s is
+   kept in double-double and the rest is a series in s^2. */
+static inline double maths_logdd(double x, double *low)
+{
+   double m, e, f, den, denlow, s, slow, z, series, high, sum, error, tiny;
+   double product, perror;
+   uint64_t bits, ebits;
+
+   tiny = (x < DBL_MIN) ? 54.0 : 0.0;
+   m = (x < DBL_MIN) ? x * 18014398509481984.0 : x;
+
+   memcpy(&bits, &m, sizeof(double));
+   ebits = (bits >> 52) | 0x4330000000000000;
+   bits = (bits & 0x000FFFFFFFFFFFFF) | 0x3FF0000000000000;
+   memcpy(&e, &ebits, sizeof(double));
+   memcpy(&m, &bits, sizeof(double));
+   e = e - (4503599627370496.0 + 1023.0) - tiny;
+
+   // m is moved into [sqrt(1/2), sqrt(2)), so |s| < 0.172.
+   e = (m > M_SQRT2) ? e + 1.0 : e;
+   m = (m > M_SQRT2) ? 0.5 * m : m;
+   f = m - 1.0;
+   den = m + 1.0, product = den - m;
+   denlow = (m - (den - product)) + (1.0 - product);
+
+   // s + slow = f / (den + denlow), where slow is found from residual.
+   s = f / den;
+   maths_mul2(s, den, &product, &perror);
+   slow = ((f - product) - perror - s * denlow) / den;
+
+   // 2 atanh(s) - 2s = 2s (s^2/3 + s^4/5 + ...), exact to 2^-60 of 2s.
+   z = s * s;
+   series = ((((((((((1.0 / 25.0 * z + 1.0 / 23.0) * z + 1.0 / 21.0) * z + 
+            1.0 / 19.0) * z + 1.0 / 17.0) * z + 1.0 / 15.0) * z + 
+            1.0 / 13.0) * z + 1.0 / 11.0) * z + 1.0 / 9.0) * z + 
+            1.0 / 7.0) * z + 1.0 / 5.0) * z + 1.0 / 3.0;
+   series = 2.0 * s * z * series;
+
+   // e * ln2 is split by high and low parts of ln2, then terms are summed
+   // from the largest with two-sum.
+   maths_mul2(e, 6.93147180559945286227e-01, &high, &error);
+   sum = high + 2.0 * s, product = sum - high;
+   error += (high - (sum - product)) + (2.0 * s - product);
+   error += e * 2.31904681384629955842e-17 + 2.0 * slow + series;
+
+   high = sum + error;
+   *low = error - (high - sum);
+   return high;
+}
+
+/* Contraction into fma would break exact sums and products of 
+   double-double arithmetic, so it is turned off for this kernel. */
+static ALAT_SIMD __attribute__((optimize("fp-contract=off"))) 
+void maths_kpow(double *fresult, double *sresult, const double *fx, 
+                const double *sx, double value, size_t n, mathmode_t mode)
+{
+   double result, base[256], high, low, y, error;
+   size_t i, start, size;
+   bool_t integer, odd;
+   unsigned int k;
+
+   // Special exponents are rewritten into cheaper exact operations.
+   if (value == 2.0) {
+      for (i = 0; i < n; i++)
+         fresult[i] = fx[i] * fx[i];
+   }
+   else if (value == 0.5) {
+      // pow(-0, 0.5) is +0 and pow(-inf, 0.5) is +inf unlike sqrt.
+      for (i = 0; i < n; i++)
+         fresult[i] = (fx[i] == -INFINITY) ? INFINITY : sqrt(fx[i]) + 0.0;
+   }
+   else if (value == 1.0 / 3.0 && mode == MATH_STRICT) {
+      // pow has no real results for negative finite bases, and it gives +0
+      // and +inf for -0 and -inf unlike cbrt.
+      for (i = 0; i < n; i++)
+         fresult[i] = (fx[i] < 0.0 && fx[i] != -INFINITY) ? NAN :
+                      cbrt(fabs(fx[i]));
+   }
+   else if (value == 1.0 / 3.0) {
+      for (i = 0; i < n; i++)
+         fresult[i] = (fx[i] < 0.0 && fx[i] != -INFINITY) ? NAN :
+                      alat_cbrt(fabs(fx[i]));
+   }
+   else if (mode == MATH_STRICT) {
+      for (i = 0; i < n; i++)
+         fresult[i] = pow(fx[i], value);
+   }
+   else if (value == floor(value) && fabs(value) <= MATHS_POWI) {
+      // Small integer exponents are multiplied by squaring in blocks.
+      for (start = 0; start < n; start += size) {
+         size = (n - start < 256) ? n - start : 256;
+         for (i = 0; i < size; i++)
+            base[i] = fx[start+i], fresult[start+i] = 1.0;
+         for (k = (unsigned int) fabs(value); k > 0; k >>= 1) {
+            if (k & 1)
+               for (i = 0; i < size; i++)
+                  fresult[start+i] *= base[i];
+            for (i = 0; i < size; i++)
+               base[i] *= base[i];
+         }
+         if (value < 0.0)
+            for (i = 0; i < size; i++)
+               fresult[start+i] = 1.0 / fresult[start+i];
+      }
+   }
+   else {
+      integer = (value == floor(value));
+      odd = (integer && fmod(value, 2.0) != 0.0);
+
+      // Bases of result are positive, so signs are settled by exponent.
+      // Logarithm and its product with exponent are kept in double-double.
+      for (i = 0; i < n; i++) {
+         high = maths_logdd(fabs(fx[i]), &low);
+         maths_mul2(value, high, &y, &error);
+         result = alat_expdd(y, error + value * low);
+         fresult[i] = (fx[i] == 1.0) ? 1.0 : result;
+      }
+      // Bases of zeros, infinities and NaNs, and results out of normal
+      // range are taken from libm.
+      for (i = 0; i < n; i++)
+         if (fx[i] == 0.0 || !isfinite(fx[i]) ||
+             !(fresult[i] >= DBL_MIN && fresult[i] <= DBL_MAX))
+            fresult[i] = pow(fabs(fx[i]), value);
+      if (odd)
+         for (i = 0; i < n; i++)
+            fresult[i] = copysign(fresult[i], fx[i]);
+      else if (!integer)
+         for (i = 0; i < n; i++)
+            fresult[i] = (fx[i] < 0.0 && fx[i] != -INFINITY) ? NAN :
+                         fresult[i];
+   }
+}
+
+static ALAT_SIMD void maths_ksincosd(double *fresult, double *sresult,
+                                     const double *fx, const double *sx,
+                                     double value, size_t n, mathmode_t mode)
+{
+   size_t i;
+
+   if (mode == MATH_STRICT)
+      for (i = 0; i < n; i++)
+         alat_sincosd(fx[i], fresult + i, sresult + i, true);
+   else
+      for (i = 0; i < n; i++)
+         alat_sincosd(fx[i], fresult + i, sresult + i, false);
+}
+
+static ALAT_SIMD void maths_katan2d(double *fresult, double *sresult,
+                                    const double *fx, const double *sx,
+                                    double value, size_t n, mathmode_t mode)
+{
+   size_t i;
+
+   if (mode == MATH_STRICT)
+      for (i = 0; i < n; i++)
+         fresult[i] = DEG(atan2(fx[i], sx[i]));
+   else
+      for (i = 0; i < n; i++)
+         fresult[i] = alat_atan2(fx[i], sx[i]) * (180.0 / M_PI);
+}
+
+static ALAT_SIMD void maths_kacosd(double *fresult, double *sresult,
+                                   const double *fx, const double *sx,
+                                   double value, size_t n, mathmode_t mode)
+{
+   size_t i;
+
+   // acos(x) is atan2(sqrt(1 - x^2), x), which is accurate near -1 and 1.
+   if (mode == MATH_STRICT)
+      for (i = 0; i < n; i++)
+         fresult[i] = DEG(acos(fx[i]));
+   else
+      for (i = 0; i < n; i++)
+         fresult[i] = alat_atan2(sqrt((1.0 - fx[i]) * (1.0 + fx[i])), fx[i]) *
+                      (180.0 / M_PI);
+}
+
+static ALAT_SIMD void maths_kscale(double *fresult, double *sresult,
+                                   const double *fx, const double *sx,
+                                   double value, size_t n, mathmode_t mode)
+{
+   size_t i;
+
+   for (i = 0; i < n; i++)
+      fresult[i] = fx[i] * value;
+}
+
+/**
+ * Calculate the square roots of `n` elements of `x` into `result`.
+ * `result` may be same as `x` in all math methods.
+ */
+void maths_sqrt(double *result, const double *x, size_t n)
+{
+   maths_run(maths_ksqrt, result, NULL, x, NULL, 0.0, n);
+}
+
+/**
+ * Calculate the cube roots of `n` elements of `x` into `result`.
+ */
+void maths_cbrt(double *result, const double *x, size_t n)
+{
+   maths_run(maths_kcbrt, result, NULL, x, NULL, 0.0, n);
+}
+
+/**
+ * Calculate the exponentials of `n` elements of `x` into `result`.
+ */
+void maths_exp(double *result, const double *x, size_t n)
+{
+   maths_run(maths_kexp, result, NULL, x, NULL, 0.0, n);
+}
+
+/**
+ * Calculate the natural logarithms of `n` elements of `x` into `result`.
+ */
+void maths_log(double *result, const double *x, size_t n)
+{
+   maths_run(maths_klog, result, NULL, x, NULL, 0.0, n);
+}
+
+/**
+ * Raise `n` elements of `x` to `exponent` power into `result`. Exponents
+ * 0, 1, -1, 2 and 1/2 are rewritten into exact operations, and 1/3 into
+ * cube roots of non-negative elements. In fast mode, integer exponents up
+ * to 4 are multiplied by squaring, and others are exp(exponent * log(x))
+ * in double-double, so results are accurate to about 4 ulp.
+ */
+void maths_pow(double *result, const double *x, double exponent, size_t n)
+{
+   size_t i;
+
+   if (exponent == 0.0) {
+      for (i = 0; i < n; i++)
+         result[i] = 1.0;
+   }
+   else if (exponent == 1.0) {
+      memmove(result, x, sizeof(double) * n);
+   }
+   else if (exponent == -1.0) {
+      for (i = 0; i < n; i++)
+         result[i] = 1.0 / x[i];
+   }
+   else
+      maths_run(maths_kpow, result, NULL, x, NULL, exponent, n);
+}
+
+/**
+ * Calculate sines and cosines of `n` angles of `deg` (in degrees) into
+ * `sine` and `cosine`. Angles are reduced by right angles exactly.
+ */
+void maths_sincosd(double *sine, double *cosine, const double *deg, size_t n)
+{
+   maths_run(maths_ksincosd, sine, cosine, deg, NULL, 0.0, n);
+}
+
+/**
+ * Calculate the angles (in degrees) of `n` points which have coordinates
+ * in `x` and `y` into `result`.
+ */
+void maths_atan2d(double *result, const double *y, const double *x, size_t n)
+{
+   maths_run(maths_katan2d, result, NULL, y, x, 0.0, n);
+}
+
+/**
+ * Calculate the arc cosines (in degrees) of `n` elements of `x` into
+ * `result`.
+ */
+void maths_acosd(double *result, const double *x, size_t n)
+{
+   maths_run(maths_kacosd, result, NULL, x, NULL, 0.0, n);
+}
+
+/**
+ * Convert `n` elements of `x` from radians to degrees into `result`.
+ */
+void maths_degrees(double *result, const double *x, size_t n)
+{
+   maths_run(maths_kscale, result, NULL, x, NULL, 180.0 / M_PI, n);
+}
+
+/**
+ * Convert `n` elements of `x` from degrees to radians into `result`.
+ */
+void maths_radians(double *result, const double *x, size_t n)
+{
+   maths_run(maths_kscale, result, NULL, x, NULL, M_PI / 180.0, n);
+}
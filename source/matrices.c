@@ -132,6 +132,21 @@ bool_t matrices_isequal(matrix_t fmatrix, matrix_t smatrix)
    return true;
 }
  
+/**
+ * Return true, if `matrix` just contains integers, otherwise return 
+ * false. Integers must be exactly representable in double.
+ */
+bool_t matrices_isinteger(matrix_t matrix)
+{
+   for (int i=0; i<matrix.shape.row; i++)
+      for (int j=0; j<matrix.shape.col; j++)
+         if (matrix.matrix[i][j] != floor(matrix.matrix[i][j]) ||
+             fabs(matrix.matrix[i][j]) > 9007199254740992.0)
+            return false;
+
+   return true;
+}
+
 /** 
  * Return true, if `matrix` is invertible, otherwise return false. 
  */
@@ -514,13 +529,12 @@ matrix_t matrices_abs(matrix_t matrix)
 matrix_t matrices_pow(matrix_t matrix, double n)
 {
    matrix_t result;
-   int i, j;
+   int i;
 
    result.shape = matrix.shape;
 
    for (i = 0; i < result.shape.row; i++)
-      for (j = 0; j < result.shape.col; j++)
-         result.matrix[i][j] = pow(matrix.matrix[i][j], n);
+      maths_pow(result.matrix[i], matrix.matrix[i], n, result.shape.col);
 
    return result;
 }
@@ -537,13 +551,12 @@ matrix_t matrices_root(matrix_t matrix, double n)
 matrix_t matrices_degrees(matrix_t matrix)
 {
    matrix_t result;
-   int i, j;
+   int i;
 
    result.shape = matrix.shape;
 
    for (i = 0; i < result.shape.row; i++) 
-      for (j = 0; j < result.shape.col; j++) 
-         result.matrix[i][j] = DEG(matrix.matrix[i][j]);
+      maths_degrees(result.matrix[i], matrix.matrix[i], result.shape.col);
 
    return result;
 }
@@ -552,13 +565,12 @@ matrix_t matrices_degrees(matrix_t matrix)
 matrix_t matrices_radians(matrix_t matrix)
 {
    matrix_t result;
-   int i, j;
+   int i;
 
    result.shape = matrix.shape;
 
    for (i = 0; i < result.shape.row; i++) 
-      for (j = 0; j < result.shape.col; j++) 
-         result.matrix[i][j] = RAD(matrix.matrix[i][j]);
+      maths_radians(result.matrix[i], matrix.matrix[i], result.shape.col);
 
    return result;
 }
@@ -932,20 +944,129 @@ matrix_t matrices_dot_div(matrix_t fmatrix, matrix_t smatrix)
    return matrices_dot_mul(fmatrix, matrices_swap(smatrix));
 }
 
+/**
+ * Run the Bareiss fraction-free elimination on integer `matrix` in 
+ * 64-bit integers. Every intermediate value is a minor of `matrix`, so 
+ * the divisions are exact and no round-off occurs. The determinant (for 
+ * square matrices) is stored in `det` and the rank in `rank`. Return 
+ * false, if an intermediate value overflows 64-bit integer.
+ */
+static bool_t matrices_bareiss(matrix_t *matrix, long long *det, int *rank)
+{
+   long long array[ROW][COL], temp, prev;
+   __int128 value;
+   int i, j, k, r, pivot, switching;
+
+   for (i = 0; i < matrix->shape.row; i++)
+      for (j = 0; j < matrix->shape.col; j++)
+         array[i][j] = (long long) matrix->matrix[i][j];
+
+   r = 0; prev = 1; switching = 1;
+
+   for (k = 0; k < matrix->shape.col && r < matrix->shape.row; k++) {
+
+      // Find the nonzero pivot in k.th column, otherwise skip the column.
+      for (pivot = r; pivot < matrix->shape.row; pivot++)
+         if (array[pivot][k] != 0)
+            break;
+      if (pivot == matrix->shape.row)
+         continue;
+
+      if (pivot != r) {
+         for (j = 0; j < matrix->shape.col; j++)
+            temp = array[r][j], array[r][j] = array[pivot][j],
+            array[pivot][j] = temp;
+         switching *= -1;
+      }
+      // Eliminate the rows below the pivot without leaving integers.
+      for (i = r + 1; i < matrix->shape.row; i++) {
+         for (j = k + 1; j < matrix->shape.col; j++) {
+            value = ((__int128) array[i][j] * array[r][k] -
+                     (__int128) array[i][k] * array[r][j]) / prev;
+            if (value > INT64_MAX || value < INT64_MIN)
+               return false;
+            array[i][j] = (long long) value;
+         }
+         array[i][k] = 0;
+      }
+      prev = array[r][k];
+      r ++;
+   }
+
+   *rank = r;
+   if (matrix->shape.row == matrix->shape.col && r == matrix->shape.row)
+      *det = switching * array[r-1][r-1];
+   else
+      *det = 0;
+
+   return true;
+}
+
+/**
+ * Reduce the `matrix` into row echelon form using Gaussian elimination 
+ * with partial pivoting. The determinant (for square matrices) is stored 
+ * in `det` and the rank in `rank`.
+ */
+static void matrices_gauss(matrix_t *matrix, double *det, int *rank)
+{
+   double temp, coef, tol, high;
+   int i, j, k, r, pivot;
+
+   r = 0; *det = 1.0;
+
+   // Elements smaller than 'tol' are accepted as round-off zeros.
+   high = 0.0;
+   for (i = 0; i < matrix->shape.row; i++)
+      for (j = 0; j < matrix->shape.col; j++)
+         if (fabs(matrix->matrix[i][j]) > high)
+            high = fabs(matrix->matrix[i][j]);
+   tol = high * DBL_EPSILON * (matrix->shape.row > matrix->shape.col ? 
+         matrix->shape.row : matrix->shape.col);
+
+   for (k = 0; k < matrix->shape.col && r < matrix->shape.row; k++) {
+
+      // Choose the largest element in k.th column as pivot.
+      pivot = r;
+      for (i = r + 1; i < matrix->shape.row; i++)
+         if (fabs(matrix->matrix[i][k]) > fabs(matrix->matrix[pivot][k]))
+            pivot = i;
+      if (fabs(matrix->matrix[pivot][k]) <= tol) {
+         *det = 0.0;
+         continue;
+      }
+
+      if (pivot != r) {
+         for (j = 0; j < matrix->shape.col; j++)
+            temp = matrix->matrix[r][j], 
+            matrix->matrix[r][j] = matrix->matrix[pivot][j],
+            matrix->matrix[pivot][j] = temp;
+         *det *= -1.0;
+      }
+      for (i = r + 1; i < matrix->shape.row; i++) {
+         coef = matrix->matrix[i][k] / matrix->matrix[r][k];
+         for (j = k; j < matrix->shape.col; j++)
+            matrix->matrix[i][j] -= coef * matrix->matrix[r][j];
+      }
+      *det *= matrix->matrix[r][k];
+      r ++;
+   }
+
+   *rank = r;
+}
+
 /** 
- * Calculate the determinant of `matrix`. 
+ * Calculate the determinant of `matrix`. If all elements of `matrix` 
+ * are integers, the determinant is calculated exactly.
  */
 double matrices_det(matrix_t matrix)
 {
-   matrix_t fsubmat, ssubmat, res;
-   double det, coef, array[matrix.shape.row];
-   int i, j, k, switching, nonzero;
+   long long idet;
+   double det;
+   int rank;
 
    if (matrix.shape.row != matrix.shape.col) 
       alat_error("Dimension dimatch found");
 
-   k = 0; switching = 1; nonzero = -1; det = 1.0;
-
    // Calculate the determinant of 1x1 matrix.
    if (matrix.shape.row == 1)
       return matrix.matrix[0][0];
@@ -956,53 +1077,32 @@ double matrices_det(matrix_t matrix)
              matrix.matrix[0][1] * matrix.matrix[1][0];
 
    // Calculate the determinant of 3x3 and more matrix.
-   while (true) {
-      for (i = 1 + k; i < matrix.shape.row; i++) {
-
-         fsubmat.shape.row = 1; fsubmat.shape.col = matrix.shape.col;
-         ssubmat.shape.row = 1; ssubmat.shape.col = matrix.shape.col;
-
-         // If the main diagonal of 'matrix' contains zero, in this 
-         // case make replacement between rows of 'matrix'.
-         if (matrix.matrix[k][k] == 0.0) {
-            // Find the nonzero element in the diagonal.
-            for (j = 0; j < matrix.shape.row; j++)
-               if (matrix.matrix[j][k] != 0.0)
-                  nonzero = j;
-            // Iff all elements of an column are zeros, exit process.
-            if (nonzero == -1)
-               return 0;
-
-            for (j = 0; j < matrix.shape.col; j++) {
-               array[j] = matrix.matrix[k][j];
-               matrix.matrix[k][j] = matrix.matrix[nonzero][j];
-               matrix.matrix[nonzero][j] = array[j];
-            }
-            switching *= -1;
-         }
-         // Calculate the coefficient of related rows.
-         coef = -1 * matrix.matrix[i][k] / matrix.matrix[k][k];
+   if (matrices_isinteger(matrix) && 
+       matrices_bareiss(&matrix, &idet, &rank))
+      return (double) idet;
 
-         // Prepare the rows to replace with each other.
-         for (j = 0; j < matrix.shape.col; j++) {
-            fsubmat.matrix[0][j] = matrix.matrix[k][j];
-            ssubmat.matrix[0][j] = matrix.matrix[i][j];
-         }
-         res = matrices_add(ssubmat, matrices_scaler_mul(fsubmat, coef));
+   matrices_gauss(&matrix, &det, &rank);
 
-         for (j = 0; j < matrix.shape.col; j++)
-            matrix.matrix[i][j] = res.matrix[0][j];
-      }
-      // Break up the loop after the upper triangle matrix occured.
-      k ++;
-      if (k == matrix.shape.row)
-         break;
-   }
-   // Calculate the determinant of 'matrix' using triangle matrix.
-   for (i = 0; i < matrix.shape.row; i++)
-      det *= matrix.matrix[i][i];
+   return det;
+}
+
+/**
+ * Calculate the rank of `matrix`. If all elements of `matrix` are
+ * integers, the rank is calculated exactly.
+ */
+int matrices_rank(matrix_t matrix)
+{
+   long long idet;
+   double det;
+   int rank;
+
+   if (matrices_isinteger(matrix) && 
+       matrices_bareiss(&matrix, &idet, &rank))
+      return rank;
 
-   return det * switching;
+   matrices_gauss(&matrix, &det, &rank);
+
+   return rank;
 }
 
 /**
@@ -1091,15 +1191,63 @@ matrix_t matrices_adjoint(matrix_t matrix)
 }
 
 /**
- * Calculate the inverse of `matrix`.
+ * Calculate the inverse of `matrix` using Gauss-Jordan elimination. If
+ * all elements of `matrix` are integers, the inverse is rounded so that
+ * its multiple by determinant is exactly the integer adjoint.
  */
 matrix_t matrices_inverse(matrix_t matrix)
 {
-   if (!matrices_isinvertible(matrix)) 
+   matrix_t result;
+   double det, temp, coef;
+   bool_t isinteger;
+   int i, j, k, pivot;
+
+   det = matrices_det(matrix);
+   if (det == 0.0) 
       alat_error("Non-invetible matrix found");
 
-   return matrices_scaler_div(matrices_adjoint(matrix), 
-                              matrices_det(matrix));
+   isinteger = matrices_isinteger(matrix);
+   result = matrices_identity(matrix.shape);
+
+   // Reduce 'matrix' into identity and apply same row operations
+   // on 'result'.
+   for (k = 0; k < matrix.shape.row; k++) {
+
+      pivot = k;
+      for (i = k + 1; i < matrix.shape.row; i++)
+         if (fabs(matrix.matrix[i][k]) > fabs(matrix.matrix[pivot][k]))
+            pivot = i;
+
+      if (pivot != k) {
+         for (j = 0; j < matrix.shape.col; j++) {
+            temp = matrix.matrix[k][j], matrix.matrix[k][j] = 
+               matrix.matrix[pivot][j], matrix.matrix[pivot][j] = temp;
+            temp = result.matrix[k][j], result.matrix[k][j] = 
+               result.matrix[pivot][j], result.matrix[pivot][j] = temp;
+         }
+      }
+
+      coef = 1.0 / matrix.matrix[k][k];
+      for (j = 0; j < matrix.shape.col; j++)
+         matrix.matrix[k][j] *= coef, result.matrix[k][j] *= coef;
+
+      for (i = 0; i < matrix.shape.row; i++) {
+         if (i == k || matrix.matrix[i][k] == 0.0)
+            continue;
+         coef = matrix.matrix[i][k];
+         for (j = 0; j < matrix.shape.col; j++) {
+            matrix.matrix[i][j] -= coef * matrix.matrix[k][j];
+            result.matrix[i][j] -= coef * result.matrix[k][j];
+         }
+      }
+   }
+
+   if (isinteger)
+      for (i = 0; i < result.shape.row; i++)
+         for (j = 0; j < result.shape.col; j++)
+            result.matrix[i][j] = round(result.matrix[i][j] * det) / det;
+
+   return result;
 }
 
 /**
@@ -1129,3 +1277,502 @@ matrix_t matrices_solve(matrix_t matrix)
 
    return matrices_cross_mul(matrices_inverse(main), target);
 }
+
+/**
+ * Multiply `fmatrix` and `smatrix` as cross into `result`, which must not
+ * be same as them. Rows of `smatrix` are accumulated in i-k-j order, so
+ * the inner loop runs over contiguous elements and is vectorized. If 
+ * `upper` is true, both matrices are taken as upper triangular and only 
+ * their nonzero parts are multiplied.
+ */
+static ALAT_SIMD void matrices_kmul(matrix_t *restrict result, 
+                                    const matrix_t *restrict fmatrix,
+                                    const matrix_t *restrict smatrix,
+                                    bool_t upper)
+{
+   int i, j, k, row = fmatrix->shape.row, col = smatrix->shape.col;
+   double coef;
+
+   result->shape.row = row, result->shape.col = col;
+
+   for (i = 0; i < row; i++) {
+      for (j = 0; j < col; j++)
+         result->matrix[i][j] = 0.0;
+      for (k = upper ? i : 0; k < fmatrix->shape.col; k++) {
+         coef = fmatrix->matrix[i][k];
+         for (j = upper ? k : 0; j < col; j++)
+            result->matrix[i][j] += coef * smatrix->matrix[k][j];
+      }
+   }
+}
+
+/**
+ * Raise the square `matrix` to `n` power by binary exponentiation, which 
+ * takes about 2 * log2(n) products in three reused buffers. Negative `n`
+ * raises the inverse of `matrix`. Diagonal matrices are raised by their
+ * elements, and triangular ones multiply only their nonzero triangles.
+ */
+matrix_t matrices_matpow(matrix_t matrix, long n)
+{
+   matrix_t buffers[3], *result, *base, *temp, *swap;
+   bool_t lower, upper;
+   unsigned long k;
+   int i;
+
+   if (matrices_issquare(matrix) == false)
+      alat_error("Dimension dismatch found");
+
+   if (n < 0)
+      matrix = matrices_inverse(matrix);
+   k = (n < 0) ? -(unsigned long) n : (unsigned long) n;
+
+   upper = matrices_isuppertri(matrix);
+   lower = matrices_islowertri(matrix);
+
+   if (upper && lower) {
+      for (i = 0; i < matrix.shape.row; i++)
+         matrix.matrix[i][i] = pow(matrix.matrix[i][i], (double) k);
+      return matrix;
+   }
+
+   // Lower triangular powers are transposes of upper triangular ones.
+   if (lower)
+      matrix = matrices_transpose(matrix);
+
+   result = &buffers[0], base = &buffers[1], temp = &buffers[2];
+   *result = matrices_identity(matrix.shape);
+   *base = matrix;
+
+   for (; k > 0; k >>= 1) {
+      if (k & 1) {
+         matrices_kmul(temp, result, base, upper || lower);
+         swap = result, result = temp, temp = swap;
+      }
+      if (k > 1) {
+         matrices_kmul(temp, base, base, upper || lower);
+         swap = base, base = temp, temp = swap;
+      }
+   }
+
+   if (lower)
+      return matrices_transpose(*result);
+
+   return *result;
+}
+
+/**
+ * Solve `main` X = `target` in place of `target` using LU decomposition 
+ * with partial pivoting. `main` is overwritten by its factors.
+ */
+static void matrices_lusolve(matrix_t *main, matrix_t *target)
+{
+   int i, j, k, pivot, n = main->shape.row;
+   double temp, coef;
+
+   for (k = 0; k < n; k++) {
+      pivot = k;
+      for (i = k + 1; i < n; i++)
+         if (fabs(main->matrix[i][k]) > fabs(main->matrix[pivot][k]))
+            pivot = i;
+      if (main->matrix[pivot][k] == 0.0)
+         alat_error("Non-invetible matrix found");
+
+      if (pivot != k) {
+         for (j = 0; j < n; j++)
+            temp = main->matrix[k][j], 
+            main->matrix[k][j] = main->matrix[pivot][j],
+            main->matrix[pivot][j] = temp;
+         for (j = 0; j < target->shape.col; j++)
+            temp = target->matrix[k][j], 
+            target->matrix[k][j] = target->matrix[pivot][j],
+            target->matrix[pivot][j] = temp;
+      }
+
+      for (i = k + 1; i < n; i++) {
+         coef = main->matrix[i][k] / main->matrix[k][k];
+         for (j = k + 1; j < n; j++)
+            main->matrix[i][j] -= coef * main->matrix[k][j];
+         for (j = 0; j < target->shape.col; j++)
+            target->matrix[i][j] -= coef * target->matrix[k][j];
+      }
+   }
+
+   for (k = n - 1; k >= 0; k--) {
+      for (i = k + 1; i < n; i++)
+         for (j = 0; j < target->shape.col; j++)
+            target->matrix[k][j] -= main->matrix[k][i] * target->matrix[i][j];
+      coef = 1.0 / main->matrix[k][k];
+      for (j = 0; j < target->shape.col; j++)
+         target->matrix[k][j] *= coef;
+   }
+}
+
+/**
+ * Calculate the matrix exponential of square `matrix` by scaling and 
+ * squaring with Pade approximants of degree 3, 5, 7, 9 or 13 (Higham, 
+ * 2005), chosen by 1-norm of `matrix`. Diagonal matrices are exponentiated
+ * by their elements. Scale the `matrix` by t before calling for e^(At).
+ */
+matrix_t matrices_expm(matrix_t matrix)
+{
+   static const double thetas[5] = {
+      1.495585217958292e-2, 2.539398330063230e-1, 9.504178996162932e-1,
+      2.097847961257068e+0, 5.371920351148152e+0
+   };
+   static const int degrees[5] = {3, 5, 7, 9, 13};
+   static const double coefs[5][14] = {
+      {120.0, 60.0, 12.0, 1.0},
+      {30240.0, 15120.0, 3360.0, 420.0, 30.0, 1.0},
+      {17297280.0, 8648640.0, 1995840.0, 277200.0, 25200.0, 1512.0, 56.0, 
+       1.0},
+      {17643225600.0, 8821612800.0, 2075673600.0, 302702400.0, 30270240.0,
+       2162160.0, 110880.0, 3960.0, 90.0, 1.0},
+      {64764752532480000.0, 32382376266240000.0, 7771770303897600.0,
+       1187353796428800.0, 129060195264000.0, 10559470521600.0, 
+       670442572800.0, 33522128640.0, 1323241920.0, 40840800.0, 960960.0,
+       16380.0, 182.0, 1.0}
+   };
+   matrix_t powers[4], odd, even, temp, *swap, *result, *square;
+   double norm, total;
+   const double *b;
+   int i, j, k, m, scale, n = matrix.shape.row;
+
+   if (matrices_issquare(matrix) == false)
+      alat_error("Dimension dismatch found");
+
+   if (matrices_isdiagonal(matrix)) {
+      for (i = 0; i < n; i++)
+         matrix.matrix[i][i] = exp(matrix.matrix[i][i]);
+      return matrix;
+   }
+
+   for (norm = 0.0, j = 0; j < n; j++) {
+      for (total = 0.0, i = 0; i < n; i++)
+         total += fabs(matrix.matrix[i][j]);
+      norm = (total > norm) ? total : norm;
+   }
+
+   // Lowest degree whose bound covers the norm is used, otherwise the
+   // matrix is scaled by 2^-scale for degree 13.
+   for (m = 0, scale = 0; m < 4 && norm > thetas[m]; m++)
+      ;
+   if (m == 4 && norm > thetas[4]) {
+      scale = (int) ceil(log2(norm / thetas[4]));
+      for (i = 0; i < n; i++)
+         for (j = 0; j < n; j++)
+            matrix.matrix[i][j] = ldexp(matrix.matrix[i][j], -scale);
+   }
+   b = coefs[m];
+
+   // Powers are A, A^2, A^4 and A^6 (only those which degree needs).
+   powers[0] = matrix;
+   matrices_kmul(&powers[1], &powers[0], &powers[0], false);
+   if (degrees[m] >= 5)
+      matrices_kmul(&powers[2], &powers[1], &powers[1], false);
+   if (degrees[m] >= 7)
+      matrices_kmul(&powers[3], &powers[2], &powers[1], false);
+
+   odd = matrices_zeros(matrix.shape), even = odd;
+   if (degrees[m] == 13) {
+      // U = A [A^6 (b13 A^6 + b11 A^4 + b9 A^2) + b7 A^6 + ... + b1 I].
+      for (i = 0; i < n; i++)
+         for (j = 0; j < n; j++) {
+            temp.matrix[i][j] = b[13] * powers[3].matrix[i][j] + 
+                                b[11] * powers[2].matrix[i][j] +
+                                b[9] * powers[1].matrix[i][j];
+            even.matrix[i][j] = b[12] * powers[3].matrix[i][j] + 
+                                b[10] * powers[2].matrix[i][j] +
+                                b[8] * powers[1].matrix[i][j];
+         }
+      temp.shape = even.shape = matrix.shape;
+      matrices_kmul(&odd, &powers[3], &temp, false);
+      matrices_kmul(&temp, &powers[3], &even, false);
+      even = temp;
+      for (i = 0; i < n; i++)
+         for (j = 0; j < n; j++) {
+            odd.matrix[i][j] += b[7] * powers[3].matrix[i][j] + 
+                                b[5] * powers[2].matrix[i][j] +
+                                b[3] * powers[1].matrix[i][j];
+            even.matrix[i][j] += b[6] * powers[3].matrix[i][j] + 
+                                 b[4] * powers[2].matrix[i][j] +
+                                 b[2] * powers[1].matrix[i][j];
+         }
+   }
+   else {
+      // U = A (b1 I + b3 A^2 + ...), V = b0 I + b2 A^2 + ...
+      for (k = 1; 2 * k <= degrees[m]; k++) {
+         if (k == 4)
+            matrices_kmul(&temp, &powers[2], &powers[2], false);
+         square = (k == 4) ? &temp : &powers[k];
+         for (i = 0; i < n; i++)
+            for (j = 0; j < n; j++) {
+               odd.matrix[i][j] += b[2*k+1] * square->matrix[i][j];
+               even.matrix[i][j] += b[2*k] * square->matrix[i][j];
+            }
+      }
+   }
+   for (i = 0; i < n; i++)
+      odd.matrix[i][i] += b[1], even.matrix[i][i] += b[0];
+   matrices_kmul(&temp, &powers[0], &odd, false);
+   odd = temp;
+
+   // Solve (V - U) R = V + U.
+   for (i = 0; i < n; i++)
+      for (j = 0; j < n; j++) {
+         temp.matrix[i][j] = even.matrix[i][j] - odd.matrix[i][j];
+         even.matrix[i][j] += odd.matrix[i][j];
+      }
+   matrices_lusolve(&temp, &even);
+
+   // Undo the scaling by squaring the result.
+   result = &even, square = &odd;
+   for (i = 0; i < scale; i++) {
+      matrices_kmul(square, result, result, false);
+      swap = result, result = square, square = swap;
+   }
+
+   return *result;
+}
+
+/* Count of multiply-adds above which sub-products are separate tasks */
+#define CHAIN_TASKS     (1 << 18)
+
+/**
+ * Multiply `mats` from `first` to `last` in the order of `splits`, and 
+ * return the product. Product of chain split after k.th matrix is stored 
+ * in `buffers[k]`, since each split belongs to one product. Large sides 
+ * of each split are multiplied as separate tasks.
+ */
+static const matrix_t *matrices_chain(const matrix_t *mats, matrix_t *buffers,
+                                      const int *splits, const double *costs,
+                                      int n, int first, int last)
+{
+   const matrix_t *left, *right;
+   int split;
+
+   if (first == last)
+      return &mats[first];
+
+   split = splits[first*n+last];
+
+   #pragma omp task shared(left) if (costs[first*n+split] > CHAIN_TASKS)
+   left = matrices_chain(mats, buffers, splits, costs, n, first, split);
+   #pragma omp task shared(right) if (costs[(split+1)*n+last] > CHAIN_TASKS)
+   right = matrices_chain(mats, buffers, splits, costs, n, split + 1, last);
+   #pragma omp taskwait
+
+   matrices_kmul(&buffers[split], left, right, false);
+
+   return &buffers[split];
+}
+
+/**
+ * Multiply `n` matrices of `mats` as cross in the order which takes the 
+ * fewest operations. The order is found by dynamic programming over 
+ * shapes in O(n^3), and floating point operations of that order (two for
+ * each multiply-add) are stored in `flops`, if it is not NULL.
+ */
+matrix_t matrices_multi_mul(int n, const matrix_t *mats, double *flops)
+{
+   matrix_t *buffers, result;
+   double *costs, cost;
+   int *splits, *dims, i, j, k, length;
+
+   if (n < 1)
+      alat_error("At least one matrix is required");
+   for (i = 0; i < n - 1; i++)
+      if (mats[i].shape.col != mats[i+1].shape.row)
+         alat_error("Dimension dismatch found");
+
+   if (n == 1) {
+      if (flops != NULL)
+         *flops = 0.0;
+      return mats[0];
+   }
+
+   costs = malloc(sizeof(double) * n * n);
+   splits = malloc(sizeof(int) * (n * n + n + 1));
+   buffers = malloc(sizeof(matrix_t) * (n - 1));
+   if (costs == NULL || splits == NULL || buffers == NULL)
+      alat_error("Memory allocation failed");
+   dims = splits + n * n;
+
+   // i.th matrix has dims[i] rows and dims[i+1] columns.
+   for (i = 0; i < n; i++)
+      dims[i] = mats[i].shape.row;
+   dims[n] = mats[n-1].shape.col;
+
+   for (i = 0; i < n; i++)
+      costs[i*n+i] = 0.0;
+   for (length = 1; length < n; length++) {
+      for (i = 0; i + length < n; i++) {
+         j = i + length;
+         costs[i*n+j] = INFINITY;
+         for (k = i; k < j; k++) {
+            cost = costs[i*n+k] + costs[(k+1)*n+j] + 
+                   (double) dims[i] * dims[k+1] * dims[j+1];
+            if (cost < costs[i*n+j])
+               costs[i*n+j] = cost, splits[i*n+j] = k;
+         }
+      }
+   }
+
+   #pragma omp parallel if (costs[n-1] > CHAIN_TASKS)
+   #pragma omp single
+   result = *matrices_chain(mats, buffers, splits, costs, n, 0, n - 1);
+
+   if (flops != NULL)
+      *flops = 2.0 * costs[n-1];
+
+   free(costs), free(splits), free(buffers);
+
+   return result;
+}
+
+/**
+ * Create the complex matrix from `real` and `imaginary` portions which
+ * must have same shape.
+ */
+cmatrix_t matrices_complex(matrix_t real, matrix_t imaginary)
+{
+   cmatrix_t result;
+
+   if (real.shape.row != imaginary.shape.row || 
+       real.shape.col != imaginary.shape.col)
+      alat_error("Dimension dismatch found");
+
+   result.re = real, result.im = imaginary;
+
+   return result;
+}
+
+/**
+ * Add the complex matrices `fmatrix` and `smatrix` with each other.
+ */
+cmatrix_t matrices_complex_add(cmatrix_t fmatrix, cmatrix_t smatrix)
+{
+   cmatrix_t result;
+
+   result.re = matrices_add(fmatrix.re, smatrix.re);
+   result.im = matrices_add(fmatrix.im, smatrix.im);
+
+   return result;
+}
+
+/**
+ * Subtract the complex matrix `smatrix` from `fmatrix`.
+ */
+cmatrix_t matrices_complex_subtract(cmatrix_t fmatrix, cmatrix_t smatrix)
+{
+   cmatrix_t result;
+
+   result.re = matrices_subtract(fmatrix.re, smatrix.re);
+   result.im = matrices_subtract(fmatrix.im, smatrix.im);
+
+   return result;
+}
+
+/**
+ * Multiply the complex matrices `fmatrix` and `smatrix` with each other
+ * as cross. The 3M method is used, so it takes three real products 
+ * instead of four.
+ */
+cmatrix_t matrices_complex_cross_mul(cmatrix_t fmatrix, cmatrix_t smatrix)
+{
+   cmatrix_t result;
+   matrix_t first, second, third;
+
+   first = matrices_cross_mul(fmatrix.re, smatrix.re);
+   second = matrices_cross_mul(fmatrix.im, smatrix.im);
+   third = matrices_cross_mul(matrices_add(fmatrix.re, fmatrix.im),
+                              matrices_add(smatrix.re, smatrix.im));
+
+   result.re = matrices_subtract(first, second);
+   result.im = matrices_subtract(matrices_subtract(third, first), second);
+
+   return result;
+}
+
+/**
+ * Return the conjugate transpose of complex `matrix`.
+ */
+cmatrix_t matrices_complex_conj_transpose(cmatrix_t matrix)
+{
+   cmatrix_t result;
+
+   result.re = matrices_transpose(matrix.re);
+   result.im = matrices_scaler_mul(matrices_transpose(matrix.im), -1.0);
+
+   return result;
+}
+
+/**
+ * Solve the complex linear equation using Gaussian elimination with partial
+ * pivoting on the augmented matrix, followed by back substitution. `matrix`
+ * must be augmented form so that `matrix` includes both main and target 
+ * equations. The solution is returned and `matrix` is left unchanged, since
+ * it's reduced as a copy. No factors are kept, so each call eliminates the
+ * system again from scratch.
+ */
+cmatrix_t matrices_complex_solve(cmatrix_t matrix)
+{
+   cmatrix_t result;
+   cnum_t coef, pivot, total;
+   double temp;
+   int i, j, k, n, high;
+
+   n = matrix.re.shape.row;
+   if (matrix.re.shape.col - n != 1)
+      alat_error("'matrix' must be augmented form");
+
+   // Reduce 'matrix' into upper triangle form.
+   for (k = 0; k < n; k++) {
+
+      high = k;
+      for (i = k + 1; i < n; i++)
+         if (fabs(matrix.re.matrix[i][k]) + fabs(matrix.im.matrix[i][k]) >
+             fabs(matrix.re.matrix[high][k]) + fabs(matrix.im.matrix[high][k]))
+            high = i;
+      if (matrix.re.matrix[high][k] == 0.0 && matrix.im.matrix[high][k] == 0.0)
+         alat_error("Non-invetible matrix found");
+
+      if (high != k) {
+         for (j = 0; j <= n; j++) {
+            temp = matrix.re.matrix[k][j], matrix.re.matrix[k][j] = 
+               matrix.re.matrix[high][j], matrix.re.matrix[high][j] = temp;
+            temp = matrix.im.matrix[k][j], matrix.im.matrix[k][j] = 
+               matrix.im.matrix[high][j], matrix.im.matrix[high][j] = temp;
+         }
+      }
+
+      pivot = complexes_cnum(matrix.re.matrix[k][k], matrix.im.matrix[k][k]);
+
+      for (i = k + 1; i < n; i++) {
+         coef = complexes_cdiv(complexes_cnum(matrix.re.matrix[i][k], 
+            matrix.im.matrix[i][k]), pivot);
+         for (j = k; j <= n; j++) {
+            total = complexes_cmul(coef, complexes_cnum(matrix.re.matrix[k][j],
+               matrix.im.matrix[k][j]));
+            matrix.re.matrix[i][j] -= total.re;
+            matrix.im.matrix[i][j] -= total.im;
+         }
+      }
+   }
+
+   result.re = matrices_zeros((shape_t) {n, 1});
+   result.im = matrices_zeros((shape_t) {n, 1});
+
+   // Apply back substitution on upper triangle form.
+   for (i = n - 1; i >= 0; i--) {
+      total = complexes_cnum(matrix.re.matrix[i][n], matrix.im.matrix[i][n]);
+      for (j = i + 1; j < n; j++)
+         total = complexes_csub(total, complexes_cmul(
+            complexes_cnum(matrix.re.matrix[i][j], matrix.im.matrix[i][j]),
+            complexes_cnum(result.re.matrix[j][0], result.im.matrix[j][0])));
+      total = complexes_cdiv(total, complexes_cnum(matrix.re.matrix[i][i], 
+                                                   matrix.im.matrix[i][i]));
+      result.re.matrix[i][0] = total.re, result.im.matrix[i][0] = total.im;
+   }
+
+   return result;
+}
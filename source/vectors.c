@@ -2,6 +2,9 @@
 
 #include "./alat.h"
 
+/* Count of elements which batch kernels process at once */
+#define VECTORS_CHUNK   65536
+
 /**
  * Return true if `vector` just contains zeros, 
  * otherwise return false.
@@ -246,6 +249,23 @@ vector_t vectors_randint(int start, int end, dim_t dim)
    return result;
 }
  
+/**
+ * Parse the `coor` string into coordinate system enumeration. `coor` must
+ * be `cartesian`, `cylindrical` or `spherical`.
+ */
+static coor_t vectors_coor(str_t coor)
+{
+   if (!strcmp(coor, "cartesian"))
+      return COOR_CARTESIAN;
+   else if (!strcmp(coor, "cylindrical"))
+      return COOR_CYLINDRICAL;
+   else if (!strcmp(coor, "spherical"))
+      return COOR_SPHERICAL;
+   else
+      alat_error("'old_coor' and `new_coor` must be 'cartesian', "
+                     "'cylindrical' or `spherical`");
+}
+
 /**
  * Transform certain three dimensional `vector` in which has defined in `old_corr` 
  * system into particular new `new_coor` system. Consistent coordinate systems are 
@@ -255,60 +275,149 @@ vector_t vectors_randint(int start, int end, dim_t dim)
 vector_t vectors_transform(vector_t vector, str_t old_coor, str_t new_coor)
 {
    vector_t result; 
+   coor_t old, new;
 
    if (vector.dim != 3)
       alat_error("Vector must be three-dimensional");
 
+   old = vectors_coor(old_coor), new = vectors_coor(new_coor);
    result.dim = 3;
+   vectors_transform_batch(result.vector, result.vector + 1, 
+                           result.vector + 2, vector.vector, 
+                           vector.vector + 1, vector.vector + 2, 1, old, new);
+
+   return result;
+}
+
+/* Angle of (x, y) in degrees by libm or fast kernel */
+#define VECTORS_ATAN2D(y, x, strict)   ((strict) ? DEG(atan2(y, x)) :        \
+                                       alat_atan2(y, x) * (180.0 / M_PI))
+
+/* Inputs are copies of a block, so no array overlaps with another one. The
+   kernel is inlined into its strict and fast versions, so `strict` is a
+   constant in each one and fast loops are vectorized. */
+static inline __attribute__((always_inline)) 
+void vectors_ktransform(double *restrict rx, double *restrict ry,
+                        double *restrict rz, const double *restrict x,
+                        const double *restrict y, const double *restrict z,
+                        size_t n, coor_t old, coor_t new, bool_t strict)
+{
+   double a, b, c, rho, sine, cosine;
+   size_t i;
+
+   // Each conversion is a separate loop, so each one is vectorized.
+   if (old == COOR_CARTESIAN && new == COOR_CYLINDRICAL) {
+      for (i = 0; i < n; i++) {
+         a = x[i], b = y[i], c = z[i];
+         rx[i] = sqrt(a * a + b * b);
+         ry[i] = VECTORS_ATAN2D(b, a, strict);
+         rz[i] = c;
+      }
+   }
+   else if (old == COOR_CARTESIAN && new == COOR_SPHERICAL) {
+      for (i = 0; i < n; i++) {
+         a = x[i], b = y[i], c = z[i];
+         rho = sqrt(a * a + b * b);
+         rx[i] = sqrt(rho * rho + c * c);
+         ry[i] = VECTORS_ATAN2D(rho, c, strict);
+         rz[i] = VECTORS_ATAN2D(b, a, strict);
+      }
+   }
+   else if (old == COOR_CYLINDRICAL && new == COOR_CARTESIAN) {
+      for (i = 0; i < n; i++) {
+         a = x[i], c = z[i];
+         alat_sincosd(y[i], &sine, &cosine, strict);
+         rx[i] = a * cosine, ry[i] = a * sine, rz[i] = c;
+      }
+   }
+   else if (old == COOR_CYLINDRICAL && new == COOR_SPHERICAL) {
+      for (i = 0; i < n; i++) {
+         a = x[i], b = y[i], c = z[i];
+         rx[i] = sqrt(a * a + c * c);
+         ry[i] = VECTORS_ATAN2D(a, c, strict);
+         rz[i] = b;
+      }
+   }
+   else if (old == COOR_SPHERICAL && new == COOR_CARTESIAN) {
+      for (i = 0; i < n; i++) {
+         a = x[i];
+         alat_sincosd(y[i], &sine, &cosine, strict);
+         rho = a * sine, c = a * cosine;
+         alat_sincosd(z[i], &sine, &cosine, strict);
+         rx[i] = rho * cosine, ry[i] = rho * sine, rz[i] = c;
+      }
+   }
+   else if (old == COOR_SPHERICAL && new == COOR_CYLINDRICAL) {
+      for (i = 0; i < n; i++) {
+         a = x[i], b = z[i];
+         alat_sincosd(y[i], &sine, &cosine, strict);
+         rx[i] = a * sine, ry[i] = b, rz[i] = a * cosine;
+      }
+   }
+}
+
+static ALAT_SIMD void vectors_ktransform_strict(double *rx, double *ry, 
+   double *rz, const double *x, const double *y, const double *z, size_t n,
+   coor_t old, coor_t new)
+{
+   vectors_ktransform(rx, ry, rz, x, y, z, n, old, new, true);
+}
 
-   if (!strcmp(old_coor, "cartesian") && !strcmp(new_coor, "cartesian")) {
-      memcpy(&result, &vector, sizeof(vector));
-   } 
-   else if (!strcmp(old_coor, "cartesian") && !strcmp(new_coor, "cylindrical")) {
-      result.vector[0] = sqrt(pow(vector.vector[0],2) + pow(vector.vector[1],2));
-      result.vector[1] = DEG(atan(vector.vector[1] / vector.vector[0]));
-      result.vector[2] = vector.vector[2];
-   }
-   else if (!strcmp(old_coor, "cartesian") && !strcmp(new_coor, "spherical")) {
-      result.vector[0] = sqrt(pow(vector.vector[0],2) + pow(vector.vector[1],2) +
-                              pow(vector.vector[2],2));
-      result.vector[1] = DEG(acos(vector.vector[2] / result.vector[0]));
-      result.vector[2] = DEG(atan(vector.vector[1] / vector.vector[0]));
-   }
-   else if (!strcmp(old_coor, "cylindrical") && !strcmp(new_coor, "cartesian")) {
-      result.vector[0] = vector.vector[0] * cos(RAD(vector.vector[1]));
-      result.vector[1] = vector.vector[0] * sin(RAD(vector.vector[1]));
-      result.vector[2] = vector.vector[2];
-   }
-   else if (!strcmp(old_coor, "cylindrical") && !strcmp(new_coor, "cylindrical")) {
-      memcpy(&result, &vector, sizeof(vector));
-   }
-   else if (!strcmp(old_coor, "cylindrical") && !strcmp(new_coor, "spherical")) {
-      result.vector[0] = sqrt(pow(vector.vector[0],2) + pow(vector.vector[2],2));
-      result.vector[1] = DEG(atan(vector.vector[0] / vector.vector[2]));
-      result.vector[2] = vector.vector[1];
-   }
-   else if (!strcmp(old_coor, "spherical") && !strcmp(new_coor, "cartesian")) {
-      result.vector[0] = vector.vector[0] * sin(RAD(vector.vector[1])) * 
-                         cos(RAD(vector.vector[2]));
-      result.vector[1] = vector.vector[0] * sin(RAD(vector.vector[1])) * 
-                         sin(RAD(vector.vector[2]));
-      result.vector[2] = vector.vector[0] * 
-                         cos(RAD(vector.vector[1]));
-   }
-   else if (!strcmp(old_coor, "spherical") && !strcmp(new_coor, "cylindrical")) {
-      result.vector[0] = vector.vector[0] * sin(RAD(vector.vector[1]));
-      result.vector[1] = vector.vector[2];
-      result.vector[2] = vector.vector[0] * cos(RAD(vector.vector[1]));
-   }
-   else if (!strcmp(old_coor, "spherical") && !strcmp(new_coor, "spherical")) {
-      memcpy(&result, &vector, sizeof(vector));
-   }
-   else 
+static ALAT_SIMD void vectors_ktransform_fast(double *rx, double *ry, 
+   double *rz, const double *x, const double *y, const double *z, size_t n,
+   coor_t old, coor_t new)
+{
+   vectors_ktransform(rx, ry, rz, x, y, z, n, old, new, false);
+}
+
+/**
+ * Transform `count` points from `old_coor` to `new_coor` coordinate system.
+ * Coordinates are given in `x`, `y` and `z` arrays and written to `rx`, `ry`
+ * and `rz` arrays, which may be same as input ones. Systems and order of 
+ * coordinates are same as `vectors_transform`, and angles are in degrees.
+ * Trigonometry follows the mode of `maths_set_mode`.
+ */
+void vectors_transform_batch(double *rx, double *ry, double *rz, 
+                             const double *x, const double *y, 
+                             const double *z, size_t count, coor_t old_coor,
+                             coor_t new_coor)
+{
+   bool_t strict;
+   long chunk;
+
+   if (old_coor > COOR_SPHERICAL || new_coor > COOR_SPHERICAL)
       alat_error("'old_coor' and `new_coor` must be 'cartesian', "
                      "'cylindrical' or `spherical`");
 
-   return result;
+   strict = (maths_get_mode() == MATH_STRICT);
+   if (old_coor == new_coor) {
+      memmove(rx, x, sizeof(double) * count);
+      memmove(ry, y, sizeof(double) * count);
+      memmove(rz, z, sizeof(double) * count);
+      return;
+   }
+
+   #pragma omp parallel for if (count > 4 * VECTORS_CHUNK)
+   for (chunk = 0; chunk < (long) ((count + VECTORS_CHUNK - 1) / VECTORS_CHUNK);
+        chunk++) {
+      size_t start = chunk * VECTORS_CHUNK, end, size;
+      double bx[256], by[256], bz[256];
+
+      // Copy blocks of input, so results may overwrite the input arrays.
+      end = (count - start < VECTORS_CHUNK) ? count : start + VECTORS_CHUNK;
+      for (; start < end; start += size) {
+         size = (end - start < 256) ? end - start : 256;
+         memcpy(bx, x + start, sizeof(double) * size);
+         memcpy(by, y + start, sizeof(double) * size);
+         memcpy(bz, z + start, sizeof(double) * size);
+         if (strict)
+            vectors_ktransform_strict(rx + start, ry + start, rz + start, bx,
+                                      by, bz, size, old_coor, new_coor);
+         else
+            vectors_ktransform_fast(rx + start, ry + start, rz + start, bx,
+                                    by, bz, size, old_coor, new_coor);
+      }
+   }
 }
 
 /**
@@ -317,15 +426,7 @@ vector_t vectors_transform(vector_t vector, str_t old_coor, str_t new_coor)
  */
 double vectors_lenght(vector_t vector)
 {
-   double res;
-   int i;
-
-   res = 0;
-
-   for (i = 0; i < vector.dim; i ++)
-      res += pow(vector.vector[i], 2);
-
-   return sqrt(res);
+   return vectors_nrm2(vector.dim, vector.vector);
 }
 
 /**
@@ -356,12 +457,10 @@ vector_t vectors_abs(vector_t vector)
 vector_t vectors_pow(vector_t vector, double n)
 {
    vector_t result;
-   int i;
 
    result.dim = vector.dim;
 
-   for (i = 0; i < result.dim; i++)
-      result.vector[i] = pow(vector.vector[i], n);
+   maths_pow(result.vector, vector.vector, n, result.dim);
 
    return result;
 }
@@ -373,12 +472,10 @@ vector_t vectors_pow(vector_t vector, double n)
 vector_t vectors_root(vector_t vector, double n)
 {
    vector_t result;
-   int i;
 
    result.dim = vector.dim;
 
-   for (i = 0; i < result.dim; i++)
-      result.vector[i] = pow(vector.vector[i], (double) 1 / 2);
+   maths_pow(result.vector, vector.vector, 1.0 / n, result.dim);
 
    return result;
 }
@@ -389,15 +486,9 @@ vector_t vectors_root(vector_t vector, double n)
  */
 vector_t vectors_unit(vector_t vector)
 {
-   vector_t result;
-   int i;
-
-   result.dim = vector.dim;
-
-   for (i = 0; i < result.dim; i++)
-      result.vector[i] = vector.vector[i] * (1 / vectors_lenght(vector));
+   vectors_scal(vector.dim, 1 / vectors_lenght(vector), vector.vector);
 
-   return result;
+   return vector;
 }
 
 /**
@@ -463,18 +554,10 @@ vector_t vectors_scaler_mul(vector_t vector, double scaler)
  */
 double vectors_distance(vector_t fvector, vector_t svector)
 {
-   double distances;
-   int i;
-
    if (fvector.dim != svector.dim) 
       alat_error("Dimension dismatch found");
 
-   distances = 0;
-
-   for (i = 0; i < fvector.dim; i++)
-      distances += pow((fvector.vector[i] - svector.vector[i]), 2);
-
-   return sqrt(distances);
+   return sqrt(vectors_sqdist(fvector.dim, fvector.vector, svector.vector));
 }
 
 /** 
@@ -483,18 +566,10 @@ double vectors_distance(vector_t fvector, vector_t svector)
  */
 double vectors_dot_mul(vector_t fvector, vector_t svector)
 {
-   double multipled;
-   int i;
-
    if (fvector.dim != svector.dim) 
       alat_error("Dimension dismatch found");
 
-   multipled = 0;
-
-   for (i = 0; i < fvector.dim; i++)
-      multipled += fvector.vector[i] * svector.vector[i];
-
-   return multipled;
+   return vectors_dot(fvector.dim, fvector.vector, svector.vector);
 }
 
 /**
@@ -535,26 +610,20 @@ vector_t vectors_cross_mul(vector_t fvector, vector_t svector)
  */
 double vectors_angle(vector_t fvector, vector_t svector, str_t form)
 {
-   double fpow, spow, muled;
-   float angle;
-   int i;
-
-   if (vectors_iszeros(fvector) || vectors_iszeros(svector))
-      alat_error("'fvector' and 'svector' must be non-zero");
+   double flen, slen, muled, angle;
 
    if (fvector.dim != svector.dim)
       alat_error("Dimension dismatch found");
 
-   angle = 0, fpow = 0, spow = 0, muled = 0;
+   // Calculate the dot and lenghts in one pass.
+   vectors_dot_nrm2(fvector.dim, fvector.vector, svector.vector, 
+                    &muled, &flen, &slen);
 
-   // Calculate the angle in form of radians.
-   muled = vectors_dot_mul(fvector, svector);
-   for (i = 0; i < fvector.dim; i++)
-      fpow += pow(fvector.vector[i], 2);
-   for (i = 0; i < svector.dim; i++)
-      spow += pow(svector.vector[i], 2);
+   if (flen == 0.0 || slen == 0.0)
+      alat_error("'fvector' and 'svector' must be non-zero");
 
-   angle = muled / (sqrt(fpow) * sqrt(spow));
+   angle = muled / (flen * slen);
+   angle = (angle > 1.0) ? 1.0 : (angle < -1.0) ? -1.0 : angle;
 
    // Return the angle in form of 'form'.
    if (!strcmp(form, "decimal"))
@@ -566,3 +635,1499 @@ double vectors_angle(vector_t fvector, vector_t svector, str_t form)
    else
       alat_error("'form' must be one of 'decimal', 'radians' or 'degrees'");
 }
+
+/**
+ * Create a new zeros handle vector which has `dim` dimension. Vectors 
+ * up to HLEN dimension are stored inline, others in heap. Handle vector
+ * must be released with `vectors_hfree`. Handles are move-only: a struct
+ * copy of a heap vector shares its elements, so use `vectors_hcopy` to 
+ * duplicate a handle and free only one of the struct copies.
+ */
+hvector_t vectors_hzeros(dim_t dim)
+{
+   hvector_t result;
+
+   result.dim = dim;
+
+   if (dim <= HLEN) {
+      memset(result.store.local, 0, sizeof(result.store.local));
+   }
+   else {
+      result.store.heap = calloc(dim, sizeof(vec_t));
+      if (result.store.heap == NULL)
+         alat_error("Memory allocation failed");
+   }
+
+   return result;
+}
+
+/**
+ * Create a new arbitrary handle vector which contains `value`s.
+ */
+hvector_t vectors_harbitrary(double value, dim_t dim)
+{
+   hvector_t result;
+   vec_t *data;
+   int i;
+
+   result = vectors_hzeros(dim);
+   data = HVECTOR(&result);
+
+   for (i = 0; i < dim; i++)
+      data[i] = value;
+
+   return result;
+}
+
+/**
+ * Create a new ones handle vector.
+ */
+hvector_t vectors_hones(dim_t dim)
+{
+   return vectors_harbitrary(1.0, dim);
+}
+
+/**
+ * Create a sequential handle vector which ranges its elements 
+ * between `start` and `end`.
+ */
+hvector_t vectors_hsequential(int start, int end, dim_t dim)
+{
+   hvector_t result;
+   vec_t *data;
+   double step;
+   int i;
+
+   result = vectors_hzeros(dim);
+   data = HVECTOR(&result);
+   step = (dim > 1) ? (double) (end - start) / (dim - 1) : 0.0;
+
+   for (i = 0; i < dim; i++)
+      data[i] = start + i * step;
+
+   return result;
+}
+
+/**
+ * Create a handle vector which has `lenght` elements of `array`.
+ */
+hvector_t vectors_harray(const double *array, dim_t lenght)
+{
+   hvector_t result;
+
+   result = vectors_hzeros(lenght);
+   memcpy(HVECTOR(&result), array, sizeof(vec_t) * lenght);
+
+   return result;
+}
+
+/**
+ * Create a handle vector from `vector`.
+ */
+hvector_t vectors_hvector(const vector_t *vector)
+{
+   return vectors_harray(vector->vector, vector->dim);
+}
+
+/**
+ * Create a deep copy of handle `vector`, which owns its own elements and
+ * must be released with `vectors_hfree` separately.
+ */
+hvector_t vectors_hcopy(const hvector_t *vector)
+{
+   return vectors_harray(HVECTOR(vector), vector->dim);
+}
+
+/**
+ * Release the memory of handle `vector`.
+ */
+void vectors_hfree(hvector_t *vector)
+{
+   if (vector->dim > HLEN)
+      free(vector->store.heap);
+
+   vector->dim = 0;
+}
+
+/**
+ * Return true if handle `vector` just contains `value`s, otherwise
+ * return false.
+ */
+bool_t vectors_hisarbitrary(const hvector_t *vector, double value)
+{
+   const vec_t *data;
+   int i;
+
+   data = HVECTOR(vector);
+
+   for (i = 0; i < vector->dim; i++)
+      if (data[i] != value)
+         return false;
+
+   return true;
+}
+
+/**
+ * Return true, if handle vectors `fvector` and `svector` are same, 
+ * otherwise return false.
+ */
+bool_t vectors_hisequal(const hvector_t *fvector, const hvector_t *svector)
+{
+   const vec_t *fdata, *sdata;
+   int i;
+
+   if (fvector->dim != svector->dim)
+      return false;
+
+   fdata = HVECTOR(fvector), sdata = HVECTOR(svector);
+
+   for (i = 0; i < fvector->dim; i++)
+      if (fdata[i] != sdata[i])
+         return false;
+
+   return true;
+}
+
+/**
+ * Calculate the lenght of handle `vector`.
+ */
+double vectors_hlenght(const hvector_t *vector)
+{
+   return vectors_nrm2(vector->dim, HVECTOR(vector));
+}
+
+/**
+ * Calculate the absolute of handle `vector` into `result`.
+ */
+void vectors_habs(hvector_t *result, const hvector_t *vector)
+{
+   const vec_t *data;
+   vec_t *res;
+   int i;
+
+   if (result->dim != vector->dim)
+      alat_error("Dimension dismatch found");
+
+   data = HVECTOR(vector), res = HVECTOR(result);
+
+   for (i = 0; i < vector->dim; i++)
+      res[i] = fabs(data[i]);
+}
+
+/**
+ * Get the `n`.th power of handle `vector` into `result`.
+ */
+void vectors_hpow(hvector_t *result, const hvector_t *vector, double n)
+{
+   const vec_t *data;
+   vec_t *res;
+
+   if (result->dim != vector->dim)
+      alat_error("Dimension dismatch found");
+
+   data = HVECTOR(vector), res = HVECTOR(result);
+
+   maths_pow(res, data, n, vector->dim);
+}
+
+/**
+ * Get the `n`.th root of handle `vector` into `result`.
+ */
+void vectors_hroot(hvector_t *result, const hvector_t *vector, double n)
+{
+   vectors_hpow(result, vector, 1 / n);
+}
+
+/**
+ * Extract the unit vector from handle `vector` into `result`.
+ */
+void vectors_hunit(hvector_t *result, const hvector_t *vector)
+{
+   vectors_hscaler_mul(result, vector, 1 / vectors_hlenght(vector));
+}
+
+/**
+ * Add the handle vectors `fvector` and `svector` into `result`.
+ */
+void vectors_hadd(hvector_t *result, const hvector_t *fvector, 
+                  const hvector_t *svector)
+{
+   const vec_t *fdata, *sdata;
+   vec_t *res;
+   int i;
+
+   if (fvector->dim != svector->dim || result->dim != fvector->dim)
+      alat_error("Dimension dismatch found");
+
+   fdata = HVECTOR(fvector), sdata = HVECTOR(svector), res = HVECTOR(result);
+
+   for (i = 0; i < result->dim; i++)
+      res[i] = fdata[i] + sdata[i];
+}
+
+/**
+ * Subtract the handle vector `svector` from `fvector` into `result`.
+ */
+void vectors_hsubtract(hvector_t *result, const hvector_t *fvector, 
+                       const hvector_t *svector)
+{
+   const vec_t *fdata, *sdata;
+   vec_t *res;
+   int i;
+
+   if (fvector->dim != svector->dim || result->dim != fvector->dim)
+      alat_error("Dimension dismatch found");
+
+   fdata = HVECTOR(fvector), sdata = HVECTOR(svector), res = HVECTOR(result);
+
+   for (i = 0; i < result->dim; i++)
+      res[i] = fdata[i] - sdata[i];
+}
+
+/**
+ * Multiply the handle `vector` with `scaler` into `result`.
+ */
+void vectors_hscaler_mul(hvector_t *result, const hvector_t *vector, 
+                         double scaler)
+{
+   const vec_t *data;
+   vec_t *res;
+   int i;
+
+   if (result->dim != vector->dim)
+      alat_error("Dimension dismatch found");
+
+   data = HVECTOR(vector), res = HVECTOR(result);
+
+   for (i = 0; i < vector->dim; i++)
+      res[i] = data[i] * scaler;
+}
+
+/**
+ * Measure the distance between handle vectors `fvector` and `svector`.
+ */
+double vectors_hdistance(const hvector_t *fvector, const hvector_t *svector)
+{
+   if (fvector->dim != svector->dim)
+      alat_error("Dimension dismatch found");
+
+   return sqrt(vectors_sqdist(fvector->dim, HVECTOR(fvector), 
+                              HVECTOR(svector)));
+}
+
+/**
+ * Multiply the handle vectors `fvector` and `svector` as dot.
+ */
+double vectors_hdot_mul(const hvector_t *fvector, const hvector_t *svector)
+{
+   if (fvector->dim != svector->dim)
+      alat_error("Dimension dismatch found");
+
+   return vectors_dot(fvector->dim, HVECTOR(fvector), HVECTOR(svector));
+}
+
+/**
+ * Multiply the three-dimensional handle vectors `fvector` and `svector` 
+ * as cross into `result`.
+ */
+void vectors_hcross_mul(hvector_t *result, const hvector_t *fvector,
+                        const hvector_t *svector)
+{
+   const vec_t *f, *s;
+   vec_t res[3];
+
+   if (fvector->dim != 3 || svector->dim != 3 || result->dim != 3)
+      alat_error("'fvector' and 'svector' must be three-dimensional");
+
+   f = HVECTOR(fvector), s = HVECTOR(svector);
+
+   res[0] = f[1] * s[2] - f[2] * s[1];
+   res[1] = f[2] * s[0] - f[0] * s[2];
+   res[2] = f[0] * s[1] - f[1] * s[0];
+
+   memcpy(HVECTOR(result), res, sizeof(res));
+}
+
+/**
+ * Calculate the angle between handle vectors `fvector` and `svector`.
+ * `form` indicates the output form of angle and must be one of 
+ * `decimal`, `radians` or `degrees`.
+ */
+double vectors_hangle(const hvector_t *fvector, const hvector_t *svector, 
+                      str_t form)
+{
+   double angle, flen, slen, muled;
+
+   if (fvector->dim != svector->dim)
+      alat_error("Dimension dismatch found");
+
+   vectors_dot_nrm2(fvector->dim, HVECTOR(fvector), HVECTOR(svector),
+                    &muled, &flen, &slen);
+
+   if (flen == 0.0 || slen == 0.0)
+      alat_error("'fvector' and 'svector' must be non-zero");
+
+   angle = muled / (flen * slen);
+   angle = (angle > 1.0) ? 1.0 : (angle < -1.0) ? -1.0 : angle;
+
+   if (!strcmp(form, "decimal"))
+      return angle;
+   else if (!strcmp(form, "radians"))
+      return acos(angle);
+   else if (!strcmp(form, "degrees"))
+      return DEG(acos(angle));
+   else
+      alat_error("'form' must be one of 'decimal', 'radians' or 'degrees'");
+}
+
+/**
+ * Multiply the `count` pairs of small vectors in `fvecs` and `svecs` as
+ * dot and write them into `result`.
+ */
+ALAT_SIMD void vectors_vec_dot_batch(double *result, const vec4_t *fvecs, 
+                                     const vec4_t *svecs, size_t count)
+{
+   size_t i;
+
+   for (i = 0; i < count; i++)
+      result[i] = vectors_vec_dot(fvecs[i], svecs[i]);
+}
+
+/**
+ * Multiply the `count` pairs of three-dimensional vectors in `fvecs` and
+ * `svecs` as cross and write them into `result`.
+ */
+ALAT_SIMD void vectors_vec_cross_batch(vec3_t *result, const vec3_t *fvecs, 
+                                       const vec3_t *svecs, size_t count)
+{
+   size_t i;
+
+   for (i = 0; i < count; i++)
+      result[i] = vectors_vec_cross(fvecs[i], svecs[i]);
+}
+
+/**
+ * Extract the unit vectors of `count` small vectors in `vecs` and write
+ * them into `result`.
+ */
+ALAT_SIMD void vectors_vec_unit_batch(vec4_t *result, const vec4_t *vecs, 
+                                      size_t count)
+{
+   size_t i;
+
+   for (i = 0; i < count; i++)
+      result[i] = vectors_vec_unit(vecs[i]);
+}
+
+/* Fused kernels which process elements in [0, n) of a chunk. */
+
+static ALAT_SIMD double vectors_kdot(const double *x, const double *y, size_t n)
+{
+   double acc[8] = {0.0};
+   size_t i, j;
+
+   // Keep eight partial sums, so that the loop is vectorized.
+   for (i = 0; i + 8 <= n; i += 8)
+      for (j = 0; j < 8; j++)
+         acc[j] += x[i+j] * y[i+j];
+   for (; i < n; i++)
+      acc[0] += x[i] * y[i];
+
+   return ((acc[0] + acc[1]) + (acc[2] + acc[3])) + 
+          ((acc[4] + acc[5]) + (acc[6] + acc[7]));
+}
+
+static ALAT_SIMD double vectors_ksqdist(const double *x, const double *y, 
+                                        size_t n)
+{
+   double acc[8] = {0.0}, diff;
+   size_t i, j;
+
+   for (i = 0; i + 8 <= n; i += 8)
+      for (j = 0; j < 8; j++)
+         diff = x[i+j] - y[i+j], acc[j] += diff * diff;
+   for (; i < n; i++)
+      diff = x[i] - y[i], acc[0] += diff * diff;
+
+   return ((acc[0] + acc[1]) + (acc[2] + acc[3])) + 
+          ((acc[4] + acc[5]) + (acc[6] + acc[7]));
+}
+
+static ALAT_SIMD void vectors_kdot3(const double *x, const double *y, size_t n,
+                                    double total[3])
+{
+   double xy[4] = {0.0}, xx[4] = {0.0}, yy[4] = {0.0};
+   size_t i, j;
+
+   for (i = 0; i + 4 <= n; i += 4)
+      for (j = 0; j < 4; j++)
+         xy[j] += x[i+j] * y[i+j], xx[j] += x[i+j] * x[i+j],
+         yy[j] += y[i+j] * y[i+j];
+   for (; i < n; i++)
+      xy[0] += x[i] * y[i], xx[0] += x[i] * x[i], yy[0] += y[i] * y[i];
+
+   total[0] = (xy[0] + xy[1]) + (xy[2] + xy[3]);
+   total[1] = (xx[0] + xx[1]) + (xx[2] + xx[3]);
+   total[2] = (yy[0] + yy[1]) + (yy[2] + yy[3]);
+}
+
+static ALAT_SIMD void vectors_kaxpby(double alpha, const double *x, double beta,
+                                     double *y, size_t n)
+{
+   size_t i;
+
+   if (beta == 1.0)
+      for (i = 0; i < n; i++)
+         y[i] += alpha * x[i];
+   else
+      for (i = 0; i < n; i++)
+         y[i] = alpha * x[i] + beta * y[i];
+}
+
+static ALAT_SIMD void vectors_kscal(double alpha, double *x, size_t n)
+{
+   size_t i;
+
+   for (i = 0; i < n; i++)
+      x[i] *= alpha;
+}
+
+/**
+ * Return the largest absolute element of `x` which has `n` elements.
+ */
+static double vectors_amax(size_t n, const double *x)
+{
+   double high;
+   size_t i;
+
+   high = 0.0;
+   for (i = 0; i < n; i++)
+      if (fabs(x[i]) > high)
+         high = fabs(x[i]);
+
+   return high;
+}
+
+/**
+ * Return true, if sum of squares `total` may be overflowed or underflowed,
+ * so that it must be recalculated with scaling.
+ */
+static bool_t vectors_unsafe(double total)
+{
+   return (isinf(total) || total < DBL_MIN / DBL_EPSILON) ? true : false;
+}
+
+/**
+ * Calculate the cosine of angle between `x` and `y` which have `n` 
+ * elements, scaling both by their largest elements.
+ */
+static double vectors_angle_cos(size_t n, const double *x, const double *y)
+{
+   double xhigh, yhigh, xy, xx, yy, xs, ys;
+   size_t i;
+
+   xhigh = vectors_amax(n, x), yhigh = vectors_amax(n, y);
+   xy = 0.0, xx = 0.0, yy = 0.0;
+
+   for (i = 0; i < n; i++)
+      xs = x[i] / xhigh, ys = y[i] / yhigh,
+      xy += xs * ys, xx += xs * xs, yy += ys * ys;
+
+   return xy / (sqrt(xx) * sqrt(yy));
+}
+
+/**
+ * Calculate `y` = `alpha` * `x` + `y` in one pass where `x` and `y` 
+ * have `n` elements.
+ */
+void vectors_axpy(size_t n, double alpha, const double *x, double *y)
+{
+   vectors_axpby(n, alpha, x, 1.0, y);
+}
+
+/**
+ * Calculate `y` = `alpha` * `x` + `beta` * `y` in one pass where `x` 
+ * and `y` have `n` elements.
+ */
+void vectors_axpby(size_t n, double alpha, const double *x, double beta,
+                   double *y)
+{
+   long chunk;
+
+   #pragma omp parallel for if (n > 4 * VECTORS_CHUNK)
+   for (chunk = 0; chunk < (long) ((n + VECTORS_CHUNK - 1) / VECTORS_CHUNK);
+        chunk++) {
+      size_t start = chunk * VECTORS_CHUNK;
+      size_t size = (n - start < VECTORS_CHUNK) ? n - start : VECTORS_CHUNK;
+
+      vectors_kaxpby(alpha, x + start, beta, y + start, size);
+   }
+}
+
+/**
+ * Multiply `x` which has `n` elements with `alpha` in place.
+ */
+void vectors_scal(size_t n, double alpha, double *x)
+{
+   long chunk;
+
+   #pragma omp parallel for if (n > 4 * VECTORS_CHUNK)
+   for (chunk = 0; chunk < (long) ((n + VECTORS_CHUNK - 1) / VECTORS_CHUNK);
+        chunk++) {
+      size_t start = chunk * VECTORS_CHUNK;
+      size_t size = (n - start < VECTORS_CHUNK) ? n - start : VECTORS_CHUNK;
+
+      vectors_kscal(alpha, x + start, size);
+   }
+}
+
+/**
+ * Multiply `x` and `y` which have `n` elements as dot.
+ */
+double vectors_dot(size_t n, const double *x, const double *y)
+{
+   double total;
+   long chunk;
+
+   total = 0.0;
+
+   #pragma omp parallel for reduction(+:total) if (n > 4 * VECTORS_CHUNK)
+   for (chunk = 0; chunk < (long) ((n + VECTORS_CHUNK - 1) / VECTORS_CHUNK);
+        chunk++) {
+      size_t start = chunk * VECTORS_CHUNK;
+      size_t size = (n - start < VECTORS_CHUNK) ? n - start : VECTORS_CHUNK;
+
+      total += vectors_kdot(x + start, y + start, size);
+   }
+
+   return total;
+}
+
+/**
+ * Calculate the squared distance between `x` and `y` which have `n` 
+ * elements.
+ */
+double vectors_sqdist(size_t n, const double *x, const double *y)
+{
+   double total;
+   long chunk;
+
+   total = 0.0;
+
+   #pragma omp parallel for reduction(+:total) if (n > 4 * VECTORS_CHUNK)
+   for (chunk = 0; chunk < (long) ((n + VECTORS_CHUNK - 1) / VECTORS_CHUNK);
+        chunk++) {
+      size_t start = chunk * VECTORS_CHUNK;
+      size_t size = (n - start < VECTORS_CHUNK) ? n - start : VECTORS_CHUNK;
+
+      total += vectors_ksqdist(x + start, y + start, size);
+   }
+
+   return total;
+}
+
+/**
+ * Calculate the euclidean norm of `x` which has `n` elements. Sum of
+ * squares is calculated directly and only if it overflows or underflows,
+ * it is recalculated with scaling by the largest element.
+ */
+double vectors_nrm2(size_t n, const double *x)
+{
+   double total, high, scaled;
+   size_t i;
+
+   total = vectors_dot(n, x, x);
+   if (!vectors_unsafe(total))
+      return sqrt(total);
+
+   high = vectors_amax(n, x);
+   if (high == 0.0 || isinf(high))
+      return high;
+
+   total = 0.0;
+   for (i = 0; i < n; i++)
+      scaled = x[i] / high, total += scaled * scaled;
+
+   return high * sqrt(total);
+}
+
+/**
+ * Calculate the dot of `x` and `y` which have `n` elements and their
+ * euclidean norms in one pass. They are written into `dot`, `xnorm` 
+ * and `ynorm`.
+ */
+void vectors_dot_nrm2(size_t n, const double *x, const double *y, 
+                      double *dot, double *xnorm, double *ynorm)
+{
+   double xy, xx, yy;
+   long chunk;
+
+   xy = 0.0, xx = 0.0, yy = 0.0;
+
+   #pragma omp parallel for reduction(+:xy,xx,yy) if (n > 4 * VECTORS_CHUNK)
+   for (chunk = 0; chunk < (long) ((n + VECTORS_CHUNK - 1) / VECTORS_CHUNK);
+        chunk++) {
+      size_t start = chunk * VECTORS_CHUNK;
+      size_t size = (n - start < VECTORS_CHUNK) ? n - start : VECTORS_CHUNK;
+      double total[3];
+
+      vectors_kdot3(x + start, y + start, size, total);
+      xy += total[0], xx += total[1], yy += total[2];
+   }
+
+   // Recalculate the values which are not safe with scaling.
+   if (vectors_unsafe(xx) || vectors_unsafe(yy) || isinf(xy)) {
+      *xnorm = vectors_nrm2(n, x), *ynorm = vectors_nrm2(n, y);
+      *dot = (*xnorm == 0.0 || *ynorm == 0.0) ? 0.0 : 
+             *xnorm * *ynorm * vectors_angle_cos(n, x, y);
+      return;
+   }
+
+   *dot = xy, *xnorm = sqrt(xx), *ynorm = sqrt(yy);
+}
+
+/* Rows and columns of pairwise result tiles, and elements of k-slices */
+#define PAIRWISE_TILE     64
+#define PAIRWISE_SLICE    128
+
+/* Columns of a tile kept in registers by `vectors_ktile` */
+#define PAIRWISE_REGS     16
+
+/**
+ * Accumulate dot products (or squared differences, if `sqdist` is true) of
+ * `frows` vectors of `fset` and 64 packed vectors over `klen` elements into
+ * `tile`. `packed` holds k.th element of j.th vector at [k][j], so 4x16
+ * blocks of `tile` are accumulated in registers over the whole slice, with
+ * each packed load shared by four rows.
+ */
+static ALAT_SIMD void vectors_ktile(double tile[PAIRWISE_TILE][PAIRWISE_TILE],
+   const double *fset, size_t stride, size_t frows,
+   const double packed[PAIRWISE_SLICE][PAIRWISE_TILE], size_t klen, 
+   bool_t sqdist)
+{
+   double acc[4][PAIRWISE_REGS], a[4], d;
+   size_t i, r, rows, j, jj, k;
+
+   for (i = 0; i < frows; i += 4) {
+      rows = (frows - i < 4) ? frows - i : 4;
+      for (j = 0; j < PAIRWISE_TILE; j += PAIRWISE_REGS) {
+         for (r = 0; r < 4; r++)
+            for (jj = 0; jj < PAIRWISE_REGS; jj++)
+               acc[r][jj] = 0.0;
+
+         for (k = 0; k < klen; k++) {
+            // Missing rows repeat the last row and are not stored.
+            for (r = 0; r < 4; r++)
+               a[r] = fset[(i + ((r < rows) ? r : rows - 1)) * stride + k];
+            for (r = 0; r < 4; r++) {
+               for (jj = 0; jj < PAIRWISE_REGS; jj++) {
+                  if (sqdist) {
+                     d = a[r] - packed[k][j+jj];
+                     acc[r][jj] += d * d;
+                  }
+                  else
+                     acc[r][jj] += a[r] * packed[k][j+jj];
+               }
+            }
+         }
+
+         for (r = 0; r < rows; r++)
+            for (jj = 0; jj < PAIRWISE_REGS; jj++)
+               tile[i+r][j+jj] += acc[r][jj];
+      }
+   }
+}
+
+/**
+ * Calculate the distances or similarities between all pairs of `fcount`
+ * vectors in `fset` and `scount` vectors in `sset`. Both sets are row-major
+ * and their vectors have `dim` elements. The element (i, j) of row-major
+ * `result` is for i.th vector of `fset` and j.th vector of `sset`. `metric`
+ * must be one of `METRIC_EUCLIDEAN`, `METRIC_SQEUCLIDEAN` or `METRIC_COSINE`
+ * (cosine similarity). If `exact` is false, euclidean metrics are found
+ * from ||a||^2 + ||b||^2 - 2a.b, otherwise differences are accumulated 
+ * directly, which is more accurate for close vectors. Either way, 64x64 
+ * tiles of `result` are accumulated over k-slices of packed `sset` vectors
+ * like a blocked matrix product.
+ */
+void vectors_pairwise(double *result, const double *fset, size_t fcount,
+                      const double *sset, size_t scount, dim_t dim,
+                      metric_t metric, bool_t exact)
+{
+   double *fnorms, *snorms;
+   bool_t sqdist;
+   long block;
+   size_t i;
+
+   if (metric != METRIC_EUCLIDEAN && metric != METRIC_SQEUCLIDEAN &&
+       metric != METRIC_COSINE)
+      alat_error("'metric' must be euclidean, squared euclidean or cosine");
+
+   fnorms = malloc(sizeof(double) * (fcount + scount + 1));
+   if (fnorms == NULL)
+      alat_error("Memory allocation failed");
+   snorms = fnorms + fcount;
+   sqdist = (exact && metric != METRIC_COSINE);
+
+   // Calculate the squared norms of all vectors once.
+   for (i = 0; i < fcount; i++)
+      fnorms[i] = vectors_kdot(fset + i * dim, fset + i * dim, dim);
+   for (i = 0; i < scount; i++)
+      snorms[i] = vectors_kdot(sset + i * dim, sset + i * dim, dim);
+
+   #pragma omp parallel for schedule(dynamic)
+   for (block = 0; block < (long) ((fcount + PAIRWISE_TILE - 1) / 
+                                   PAIRWISE_TILE); block++) {
+      double tile[PAIRWISE_TILE][PAIRWISE_TILE];
+      double packed[PAIRWISE_SLICE][PAIRWISE_TILE];
+      size_t fstart, frows, sstart, scols, kstart, klen, i, j, k;
+      double value;
+
+      fstart = block * PAIRWISE_TILE;
+      frows = (fcount - fstart < PAIRWISE_TILE) ? fcount - fstart : 
+                                                  PAIRWISE_TILE;
+
+      for (sstart = 0; sstart < scount; sstart += PAIRWISE_TILE) {
+         scols = (scount - sstart < PAIRWISE_TILE) ? scount - sstart : 
+                                                     PAIRWISE_TILE;
+         memset(tile, 0, sizeof(tile));
+
+         for (kstart = 0; kstart < dim; kstart += PAIRWISE_SLICE) {
+            klen = (dim - kstart < PAIRWISE_SLICE) ? dim - kstart : 
+                                                     PAIRWISE_SLICE;
+
+            // Pack the slice of 'sset' tile as columns (missing columns 
+            // are zeros and their results are not used).
+            for (j = 0; j < PAIRWISE_TILE; j++)
+               for (k = 0; k < klen; k++)
+                  packed[k][j] = (j < scols) ? 
+                                 sset[(sstart+j)*dim+kstart+k] : 0.0;
+
+            vectors_ktile(tile, fset + fstart * dim + kstart, dim, frows,
+                          packed, klen, sqdist);
+         }
+
+         for (i = 0; i < frows; i++) {
+            for (j = 0; j < scols; j++) {
+               value = tile[i][j];
+
+               if (metric == METRIC_COSINE) {
+                  value = (fnorms[fstart+i] == 0.0 || 
+                           snorms[sstart+j] == 0.0) ? 0.0 :
+                          value / sqrt(fnorms[fstart+i] * snorms[sstart+j]);
+               }
+               else {
+                  if (!exact)
+                     value = fnorms[fstart+i] + snorms[sstart+j] - 
+                             2.0 * value;
+                  value = (value < 0.0) ? 0.0 : value;
+                  if (metric == METRIC_EUCLIDEAN)
+                     value = sqrt(value);
+               }
+               result[(fstart+i)*scount+sstart+j] = value;
+            }
+         }
+      }
+   }
+
+   free(fnorms);
+}
+
+/* Top-k cosine similarity search over normalized vectors. */
+
+#define SIMINDEX_CHUNK     16384
+#define SIMINDEX_QUERIES   8
+
+typedef struct {
+   double score;
+   size_t index;
+} simhit_t;
+
+static ALAT_SIMD int32_t vectors_kdot8(const int8_t *x, const int8_t *y, 
+                                       size_t n)
+{
+   int32_t total = 0;
+   size_t i;
+
+   // Integer sums are associative, so this loop is vectorized as is.
+   for (i = 0; i < n; i++)
+      total += (int16_t) x[i] * y[i];
+
+   return total;
+}
+
+/* Quantize `n` elements of `x` into `codes` and return their scale. */
+static double vectors_quantize(int8_t *codes, const double *x, size_t n)
+{
+   double amax, scale;
+   size_t i;
+
+   amax = vectors_amax(n, x);
+   scale = (amax > 0.0) ? amax / 127.0 : 1.0;
+   for (i = 0; i < n; i++)
+      codes[i] = (int8_t) lround(x[i] / scale);
+
+   return scale;
+}
+
+/* Sift down the root of min-heap `heap` which has `size` hits. */
+static void vectors_heap_sift(simhit_t *heap, size_t size)
+{
+   simhit_t hit;
+   size_t i, child;
+
+   hit = heap[0];
+   for (i = 0; (child = 2 * i + 1) < size; i = child) {
+      if (child + 1 < size && heap[child+1].score < heap[child].score)
+         child++;
+      if (heap[child].score >= hit.score)
+         break;
+      heap[i] = heap[child];
+   }
+   heap[i] = hit;
+}
+
+/* Push a hit into min-heap `heap` which holds the best `k` hits. */
+static void vectors_heap_push(simhit_t *heap, size_t *size, size_t k, 
+                              double score, size_t index)
+{
+   size_t i;
+
+   if (*size < k) {
+      // Sift up the new hit from the end of heap.
+      for (i = (*size)++; i > 0 && heap[(i-1)/2].score > score; i = (i-1)/2)
+         heap[i] = heap[(i-1)/2];
+      heap[i].score = score, heap[i].index = index;
+   }
+   else if (score > heap[0].score) {
+      // Replace the worst hit and sift it down.
+      heap[0].score = score, heap[0].index = index;
+      vectors_heap_sift(heap, k);
+   }
+}
+
+/**
+ * Build similarity index of `count` vectors which have `dim` elements in 
+ * row-major `set`. Vectors are stored normalized, and if `quantize` is true,
+ * as int8 codes with one scale per vector, which takes 1/8 of memory.
+ */
+simindex_t *vectors_simindex(const double *set, size_t count, dim_t dim,
+                             bool_t quantize)
+{
+   simindex_t *index;
+   double norm;
+   long i;
+
+   if (count == 0 || dim == 0)
+      alat_error("'count' and 'dim' must be positive");
+
+   index = calloc(1, sizeof(simindex_t));
+   if (index == NULL)
+      alat_error("Memory allocation failed");
+   index->count = count, index->dim = dim, index->quantized = quantize;
+
+   if (quantize) {
+      index->codes = malloc(sizeof(int8_t) * count * dim);
+      index->scales = malloc(sizeof(double) * count);
+      if (index->codes == NULL || index->scales == NULL)
+         alat_error("Memory allocation failed");
+   }
+   else {
+      index->vectors = malloc(sizeof(double) * count * dim);
+      if (index->vectors == NULL)
+         alat_error("Memory allocation failed");
+   }
+
+   #pragma omp parallel for private(norm) if (count > 1024)
+   for (i = 0; i < (long) count; i++) {
+      // Zero vectors stay zero, so their similarities are zero.
+      norm = vectors_nrm2(dim, set + i * dim);
+      norm = (norm > 0.0) ? 1.0 / norm : 0.0;
+
+      // Quantizing doesn't depend on the norm, so it just scales the scale.
+      if (quantize)
+         index->scales[i] = norm * vectors_quantize(index->codes + i * dim,
+                                                    set + i * dim, dim);
+      else {
+         memcpy(index->vectors + i * dim, set + i * dim, sizeof(double) * dim);
+         vectors_kscal(norm, index->vectors + i * dim, dim);
+      }
+   }
+
+   return index;
+}
+
+/**
+ * Free the memory of `index`.
+ */
+void vectors_simindex_free(simindex_t *index)
+{
+   if (index == NULL)
+      return;
+
+   free(index->vectors), free(index->codes), free(index->scales);
+   free(index);
+}
+
+/**
+ * Find the `k` most similar vectors of `index` for each of `qcount` queries
+ * in row-major `queries`. Positions and cosine similarities of q.th query 
+ * are written in descending order to `indices` and `scores` from q * k. 
+ * Index is scanned in chunks, which are shared between threads, and each
+ * chunk keeps a bounded heap per query.
+ */
+void vectors_simindex_search(const simindex_t *index, size_t *indices,
+                             double *scores, const double *queries,
+                             size_t qcount, size_t k)
+{
+   size_t chunks, dim, qstart, qsize, q, i, size;
+   double *normed, *qscales, norm;
+   int8_t *qcodes;
+   simhit_t *hits, *heap;
+   size_t *sizes;
+   long chunk;
+
+   if (k == 0 || k > index->count)
+      alat_error("'k' must be in range of index");
+
+   dim = index->dim;
+   chunks = (index->count + SIMINDEX_CHUNK - 1) / SIMINDEX_CHUNK;
+   normed = malloc(sizeof(double) * SIMINDEX_QUERIES * dim);
+   qscales = malloc(sizeof(double) * SIMINDEX_QUERIES);
+   qcodes = malloc(sizeof(int8_t) * SIMINDEX_QUERIES * dim);
+   hits = malloc(sizeof(simhit_t) * (chunks + 1) * SIMINDEX_QUERIES * k);
+   sizes = malloc(sizeof(size_t) * (chunks + 1) * SIMINDEX_QUERIES);
+   if (normed == NULL || qscales == NULL || qcodes == NULL || hits == NULL ||
+       sizes == NULL)
+      alat_error("Memory allocation failed");
+
+   // Handle the queries in blocks, so each vector is loaded once per block.
+   for (qstart = 0; qstart < qcount; qstart += SIMINDEX_QUERIES) {
+      qsize = (qcount - qstart < SIMINDEX_QUERIES) ? qcount - qstart : 
+                                                     SIMINDEX_QUERIES;
+
+      for (q = 0; q < qsize; q++) {
+         norm = vectors_nrm2(dim, queries + (qstart + q) * dim);
+         memcpy(normed + q * dim, queries + (qstart + q) * dim, 
+                sizeof(double) * dim);
+         vectors_kscal((norm > 0.0) ? 1.0 / norm : 0.0, normed + q * dim, 
+                       dim);
+         if (index->quantized)
+            qscales[q] = vectors_quantize(qcodes + q * dim, normed + q * dim,
+                                          dim);
+      }
+
+      #pragma omp parallel for schedule(dynamic) private(i, q) if (chunks > 1)
+      for (chunk = 0; chunk < (long) chunks; chunk++) {
+         size_t start = chunk * SIMINDEX_CHUNK, end;
+         simhit_t *heaps = hits + chunk * SIMINDEX_QUERIES * k;
+         size_t *counts = sizes + chunk * SIMINDEX_QUERIES;
+         double score;
+
+         end = (start + SIMINDEX_CHUNK < index->count) ? 
+               start + SIMINDEX_CHUNK : index->count;
+         for (q = 0; q < qsize; q++)
+            counts[q] = 0;
+
+         for (i = start; i < end; i++) {
+            for (q = 0; q < qsize; q++) {
+               if (index->quantized)
+                  score = vectors_kdot8(index->codes + i * dim, 
+                                        qcodes + q * dim, dim) * 
+                          index->scales[i] * qscales[q];
+               else
+                  score = vectors_kdot(index->vectors + i * dim, 
+                                       normed + q * dim, dim);
+               vectors_heap_push(heaps + q * k, counts + q, k, score, i);
+            }
+         }
+      }
+
+      // Merge the heaps of chunks, and pop the best hits in order.
+      for (q = 0; q < qsize; q++) {
+         heap = hits + chunks * SIMINDEX_QUERIES * k;
+         size = 0;
+         for (chunk = 0; chunk < (long) chunks; chunk++)
+            for (i = 0; i < sizes[chunk*SIMINDEX_QUERIES+q]; i++)
+               vectors_heap_push(heap, &size, k, 
+                                 hits[(chunk*SIMINDEX_QUERIES+q)*k+i].score,
+                                 hits[(chunk*SIMINDEX_QUERIES+q)*k+i].index);
+
+         for (i = k; i-- > 0; ) {
+            indices[(qstart+q)*k+i] = heap[0].index;
+            scores[(qstart+q)*k+i] = heap[0].score;
+            heap[0] = heap[--size];
+            vectors_heap_sift(heap, size);
+         }
+      }
+   }
+
+   free(normed), free(qscales), free(qcodes), free(hits), free(sizes);
+}
+
+/* KD-tree over 2-D/3-D cartesian points. Points of subtree in [lo, hi) are 
+   split at median position (lo + hi) / 2, so the tree needs no nodes. */
+
+#define KDTREE_LEAF     8
+#define KDTREE_TASKS    (1 << 16)
+
+static void vectors_kdtree_swap(kdtree_t *tree, size_t i, size_t j)
+{
+   double *p = tree->points + i * tree->dim, *q = tree->points + j * tree->dim;
+   double value;
+   size_t index, axis;
+
+   for (axis = 0; axis < tree->dim; axis++)
+      value = p[axis], p[axis] = q[axis], q[axis] = value;
+   index = tree->order[i], tree->order[i] = tree->order[j];
+   tree->order[j] = index;
+}
+
+/* Move the `nth` smallest point on `axis` in [lo, hi) to `nth` position. */
+static void vectors_kdtree_select(kdtree_t *tree, size_t lo, size_t hi,
+                                  size_t nth, size_t axis)
+{
+   const double *points = tree->points;
+   size_t dim = tree->dim, i, j, mid;
+   double pivot;
+
+   while (hi - lo > 2) {
+      // Sort the first, middle and last points, and pivot on the middle.
+      mid = lo + (hi - lo) / 2;
+      if (points[mid*dim+axis] < points[lo*dim+axis])
+         vectors_kdtree_swap(tree, mid, lo);
+      if (points[(hi-1)*dim+axis] < points[lo*dim+axis])
+         vectors_kdtree_swap(tree, hi - 1, lo);
+      if (points[(hi-1)*dim+axis] < points[mid*dim+axis])
+         vectors_kdtree_swap(tree, hi - 1, mid);
+      pivot = points[mid*dim+axis];
+
+      for (i = lo, j = hi - 1; ; i++, j--) {
+         while (points[i*dim+axis] < pivot)
+            i++;
+         while (points[j*dim+axis] > pivot)
+            j--;
+         if (i >= j)
+            break;
+         vectors_kdtree_swap(tree, i, j);
+      }
+
+      if (nth <= j)
+         hi = j + 1;
+      else
+         lo = j + 1;
+   }
+   if (hi - lo == 2 && points[(lo+1)*dim+axis] < points[lo*dim+axis])
+      vectors_kdtree_swap(tree, lo, lo + 1);
+}
+
+static void vectors_kdtree_build(kdtree_t *tree, size_t lo, size_t hi)
+{
+   double lower[3], upper[3], spread;
+   size_t dim = tree->dim, mid, axis, i;
+
+   if (hi - lo <= KDTREE_LEAF)
+      return;
+
+   // Split on the axis which has the widest spread.
+   for (axis = 0; axis < dim; axis++)
+      lower[axis] = upper[axis] = tree->points[lo*dim+axis];
+   for (i = lo + 1; i < hi; i++)
+      for (axis = 0; axis < dim; axis++) {
+         lower[axis] = fmin(lower[axis], tree->points[i*dim+axis]);
+         upper[axis] = fmax(upper[axis], tree->points[i*dim+axis]);
+      }
+   for (spread = -1.0, i = 0, axis = 0; axis < dim; axis++)
+      if (upper[axis] - lower[axis] > spread)
+         spread = upper[axis] - lower[axis], i = axis;
+
+   mid = lo + (hi - lo) / 2;
+   tree->axes[mid] = (unsigned char) i;
+   vectors_kdtree_select(tree, lo, hi, mid, i);
+
+   // Large subtrees are built as separate tasks.
+   #pragma omp task if (hi - lo > KDTREE_TASKS)
+   vectors_kdtree_build(tree, lo, mid);
+   #pragma omp task if (hi - lo > KDTREE_TASKS)
+   vectors_kdtree_build(tree, mid + 1, hi);
+   #pragma omp taskwait
+}
+
+/**
+ * Build KD-tree of `count` cartesian points which have `dim` (2 or 3) 
+ * coordinates in `points` as (x, y) or (x, y, z). Points in cylindrical or 
+ * spherical coordinates must be transformed with `vectors_transform` first.
+ * Points are copied, so `points` may be freed after building.
+ */
+kdtree_t *vectors_kdtree(const double *points, size_t count, dim_t dim)
+{
+   kdtree_t *tree;
+   size_t i;
+
+   if (dim != 2 && dim != 3)
+      alat_error("Points must be two or three-dimensional");
+   if (count == 0)
+      alat_error("'count' must be positive");
+
+   tree = calloc(1, sizeof(kdtree_t));
+   if (tree == NULL)
+      alat_error("Memory allocation failed");
+   tree->count = count, tree->dim = dim;
+   tree->points = malloc(sizeof(double) * count * dim);
+   tree->order = malloc(sizeof(size_t) * count);
+   tree->axes = calloc(count, sizeof(unsigned char));
+   if (tree->points == NULL || tree->order == NULL || tree->axes == NULL)
+      alat_error("Memory allocation failed");
+
+   memcpy(tree->points, points, sizeof(double) * count * dim);
+   for (i = 0; i < count; i++)
+      tree->order[i] = i;
+
+   #pragma omp parallel if (count > KDTREE_TASKS)
+   #pragma omp single
+   vectors_kdtree_build(tree, 0, count);
+
+   return tree;
+}
+
+/**
+ * Free the memory of `tree`.
+ */
+void vectors_kdtree_free(kdtree_t *tree)
+{
+   if (tree == NULL)
+      return;
+
+   free(tree->points), free(tree->order), free(tree->axes);
+   free(tree);
+}
+
+static double vectors_kdtree_sqdist(const kdtree_t *tree, size_t i, 
+                                    const double *query)
+{
+   const double *point = tree->points + i * tree->dim;
+   double dx = point[0] - query[0], dy = point[1] - query[1], dz;
+
+   dz = (tree->dim == 3) ? point[2] - query[2] : 0.0;
+   return dx * dx + dy * dy + dz * dz;
+}
+
+/* Keep the nearest `k` points in `heap` with negative squared distances. */
+static void vectors_kdtree_nearest(const kdtree_t *tree, size_t lo, size_t hi,
+                                   const double *query, simhit_t *heap, 
+                                   size_t *size, size_t k)
+{
+   size_t mid, i;
+   double diff;
+
+   if (hi - lo <= KDTREE_LEAF) {
+      for (i = lo; i < hi; i++)
+         vectors_heap_push(heap, size, k, 
+                           -vectors_kdtree_sqdist(tree, i, query), i);
+      return;
+   }
+
+   mid = lo + (hi - lo) / 2;
+   diff = query[tree->axes[mid]] - tree->points[mid*tree->dim+tree->axes[mid]];
+   vectors_heap_push(heap, size, k, -vectors_kdtree_sqdist(tree, mid, query),
+                     mid);
+
+   // Visit the near side first, and the far side if it can be closer.
+   if (diff < 0.0)
+      vectors_kdtree_nearest(tree, lo, mid, query, heap, size, k);
+   else
+      vectors_kdtree_nearest(tree, mid + 1, hi, query, heap, size, k);
+
+   if (*size < k || diff * diff < -heap[0].score) {
+      if (diff < 0.0)
+         vectors_kdtree_nearest(tree, mid + 1, hi, query, heap, size, k);
+      else
+         vectors_kdtree_nearest(tree, lo, mid, query, heap, size, k);
+   }
+}
+
+/**
+ * Find the `k` nearest points of `tree` for each of `qcount` queries in
+ * `queries`. Positions of points in original array and their distances
+ * of q.th query are written in ascending order to `indices` and 
+ * `distances` from q * k. Queries are shared between threads.
+ */
+void vectors_kdtree_knn(const kdtree_t *tree, size_t *indices, 
+                        double *distances, const double *queries, 
+                        size_t qcount, size_t k)
+{
+   simhit_t *heaps;
+   long q;
+
+   if (k == 0 || k > tree->count)
+      alat_error("'k' must be in range of tree");
+
+   heaps = malloc(sizeof(simhit_t) * k * qcount);
+   if (heaps == NULL)
+      alat_error("Memory allocation failed");
+
+   #pragma omp parallel for schedule(dynamic, 64) if (qcount > 64)
+   for (q = 0; q < (long) qcount; q++) {
+      simhit_t *heap = heaps + q * k;
+      size_t size = 0, i;
+
+      vectors_kdtree_nearest(tree, 0, tree->count, queries + q * tree->dim, 
+                             heap, &size, k);
+
+      // Pop the farthest points first.
+      for (i = k; i-- > 0; ) {
+         indices[q*k+i] = tree->order[heap[0].index];
+         distances[q*k+i] = sqrt(-heap[0].score);
+         heap[0] = heap[--size];
+         vectors_heap_sift(heap, size);
+      }
+   }
+
+   free(heaps);
+}
+
+/* Collect points of [lo, hi) in the box, which is a sphere if `upper` is
+   NULL and `lower` is its center and `radius` is its squared radius. */
+static void vectors_kdtree_range(const kdtree_t *tree, size_t lo, size_t hi,
+                                 const double *lower, const double *upper,
+                                 double radius, size_t *indices, 
+                                 size_t capacity, size_t *count)
+{
+   const double *point;
+   size_t mid, axis, i, end;
+   bool_t inside;
+   double split;
+
+   while (lo < hi) {
+      mid = (hi - lo <= KDTREE_LEAF) ? hi : lo + (hi - lo) / 2;
+      end = (mid == hi) ? hi : mid + 1;
+
+      for (i = (mid == hi) ? lo : mid; i < end; i++) {
+         point = tree->points + i * tree->dim;
+         if (upper == NULL)
+            inside = (vectors_kdtree_sqdist(tree, i, lower) <= radius);
+         else
+            for (inside = true, axis = 0; axis < tree->dim; axis++)
+               if (point[axis] < lower[axis] || point[axis] > upper[axis])
+                  inside = false;
+         if (inside && (*count)++ < capacity)
+            indices[*count-1] = tree->order[i];
+      }
+      if (mid == hi)
+         return;
+
+      // Descend into the sides which overlap with the box.
+      axis = tree->axes[mid];
+      split = tree->points[mid*tree->dim+axis];
+      if (upper == NULL ? lower[axis] - sqrt(radius) <= split : 
+                          lower[axis] <= split)
+         vectors_kdtree_range(tree, lo, mid, lower, upper, radius, indices,
+                              capacity, count);
+      if (upper == NULL ? lower[axis] + sqrt(radius) >= split : 
+                          upper[axis] >= split)
+         lo = mid + 1;
+      else
+         return;
+   }
+}
+
+/**
+ * Find the points of `tree` whose distances to `query` are at most `radius`,
+ * and write at most `capacity` of their positions to `indices`. Return the
+ * count of all found points, so `indices` can be enlarged and refilled.
+ */
+size_t vectors_kdtree_radius(const kdtree_t *tree, size_t *indices, 
+                             size_t capacity, const double *query, 
+                             double radius)
+{
+   size_t count = 0;
+
+   if (radius < 0.0)
+      alat_error("'radius' must be positive");
+
+   vectors_kdtree_range(tree, 0, tree->count, query, NULL, radius * radius,
+                        indices, capacity, &count);
+   return count;
+}
+
+/**
+ * Find the points of `tree` in the box between corners `lower` and `upper`,
+ * and write at most `capacity` of their positions to `indices`. Return the
+ * count of all found points.
+ */
+size_t vectors_kdtree_box(const kdtree_t *tree, size_t *indices, 
+                          size_t capacity, const double *lower, 
+                          const double *upper)
+{
+   size_t count = 0;
+
+   vectors_kdtree_range(tree, 0, tree->count, lower, upper, 0.0, indices, 
+                        capacity, &count);
+   return count;
+}
+
+/**
+ * Create the identity transform.
+ */
+xform_t vectors_xform_identity(void)
+{
+   xform_t xform = {{{0.0}}};
+
+   xform.m[0][0] = xform.m[1][1] = xform.m[2][2] = xform.m[3][3] = 1.0;
+   return xform;
+}
+
+/**
+ * Create the transform which translates points by (`tx`, `ty`, `tz`).
+ */
+xform_t vectors_xform_translate(double tx, double ty, double tz)
+{
+   xform_t xform = vectors_xform_identity();
+
+   xform.m[0][3] = tx, xform.m[1][3] = ty, xform.m[2][3] = tz;
+   return xform;
+}
+
+/**
+ * Create the transform which scales points by (`sx`, `sy`, `sz`).
+ */
+xform_t vectors_xform_scale(double sx, double sy, double sz)
+{
+   xform_t xform = vectors_xform_identity();
+
+   xform.m[0][0] = sx, xform.m[1][1] = sy, xform.m[2][2] = sz;
+   return xform;
+}
+
+/**
+ * Create the transform which rotates points by `angle` (in degrees) 
+ * around `axis` in counter-clockwise direction.
+ */
+xform_t vectors_xform_rotate(vec3_t axis, double angle)
+{
+   xform_t xform = vectors_xform_identity();
+   double x, y, z, sine, cosine, t;
+
+   if (vectors_vec_lenght(axis) == 0.0)
+      alat_error("'axis' must be non-zero vector");
+
+   axis = vectors_vec_unit(axis);
+   x = axis.xy[0], y = axis.xy[1], z = axis.zw[0];
+   alat_sincosd(angle, &sine, &cosine, true);
+   t = 1.0 - cosine;
+
+   // Rodrigues' rotation formula
+   xform.m[0][0] = t*x*x + cosine,   xform.m[0][1] = t*x*y - sine*z;
+   xform.m[0][2] = t*x*z + sine*y,   xform.m[1][0] = t*x*y + sine*z;
+   xform.m[1][1] = t*y*y + cosine,   xform.m[1][2] = t*y*z - sine*x;
+   xform.m[2][0] = t*x*z - sine*y,   xform.m[2][1] = t*y*z + sine*x;
+   xform.m[2][2] = t*z*z + cosine;
+
+   return xform;
+}
+
+/**
+ * Create the transform from 4x4 `matrix`.
+ */
+xform_t vectors_xform_matrix(matrix_t matrix)
+{
+   xform_t xform;
+   int i, j;
+
+   if (matrix.shape.row != 4 || matrix.shape.col != 4)
+      alat_error("Matrix must be 4x4");
+
+   for (i = 0; i < 4; i++)
+      for (j = 0; j < 4; j++)
+         xform.m[i][j] = matrix.matrix[i][j];
+
+   return xform;
+}
+
+/**
+ * Compose the transform which applies `first` and then `second`.
+ */
+xform_t vectors_xform_compose(xform_t first, xform_t second)
+{
+   xform_t xform;
+   int i, j;
+
+   for (i = 0; i < 4; i++)
+      for (j = 0; j < 4; j++)
+         xform.m[i][j] = second.m[i][0] * first.m[0][j] + 
+                         second.m[i][1] * first.m[1][j] +
+                         second.m[i][2] * first.m[2][j] + 
+                         second.m[i][3] * first.m[3][j];
+
+   return xform;
+}
+
+/* Inputs are copies of a block, so no array overlaps with another one. */
+static ALAT_SIMD void vectors_kxform(const xform_t *xform, 
+                                     double *restrict rx, 
+                                     double *restrict ry,
+                                     double *restrict rz, 
+                                     const double *restrict x, 
+                                     const double *restrict y, 
+                                     const double *restrict z, size_t n,
+                                     bool_t projective)
+{
+   double m00 = xform->m[0][0], m01 = xform->m[0][1], m02 = xform->m[0][2],
+          m03 = xform->m[0][3], m10 = xform->m[1][0], m11 = xform->m[1][1], 
+          m12 = xform->m[1][2], m13 = xform->m[1][3], m20 = xform->m[2][0], 
+          m21 = xform->m[2][1], m22 = xform->m[2][2], m23 = xform->m[2][3],
+          m30 = xform->m[3][0], m31 = xform->m[3][1], m32 = xform->m[3][2],
+          m33 = xform->m[3][3], w;
+   size_t i;
+
+   if (projective) {
+      for (i = 0; i < n; i++) {
+         w = 1.0 / (m30 * x[i] + m31 * y[i] + m32 * z[i] + m33);
+         rx[i] = (m00 * x[i] + m01 * y[i] + m02 * z[i] + m03) * w;
+         ry[i] = (m10 * x[i] + m11 * y[i] + m12 * z[i] + m13) * w;
+         rz[i] = (m20 * x[i] + m21 * y[i] + m22 * z[i] + m23) * w;
+      }
+   }
+   else {
+      for (i = 0; i < n; i++) {
+         rx[i] = m00 * x[i] + m01 * y[i] + m02 * z[i] + m03;
+         ry[i] = m10 * x[i] + m11 * y[i] + m12 * z[i] + m13;
+         rz[i] = m20 * x[i] + m21 * y[i] + m22 * z[i] + m23;
+      }
+   }
+}
+
+/**
+ * Apply `xform` to `count` points given in `x`, `y` and `z` arrays, and 
+ * write them to `rx`, `ry` and `rz` arrays, which may be same as input 
+ * ones. If last row of `xform` isn't (0, 0, 0, 1), points are divided by
+ * their w coordinates.
+ */
+void vectors_xform_apply(const xform_t *xform, double *rx, double *ry, 
+                         double *rz, const double *x, const double *y,
+                         const double *z, size_t count)
+{
+   bool_t projective;
+   long chunk;
+
+   projective = (xform->m[3][0] != 0.0 || xform->m[3][1] != 0.0 || 
+                 xform->m[3][2] != 0.0 || xform->m[3][3] != 1.0);
+
+   #pragma omp parallel for if (count > 4 * VECTORS_CHUNK)
+   for (chunk = 0; chunk < (long) ((count + VECTORS_CHUNK - 1) / VECTORS_CHUNK);
+        chunk++) {
+      size_t start = chunk * VECTORS_CHUNK, end, size;
+      double bx[256], by[256], bz[256];
+
+      // Copy blocks of input, so results may overwrite the input arrays.
+      end = (count - start < VECTORS_CHUNK) ? count : start + VECTORS_CHUNK;
+      for (; start < end; start += size) {
+         size = (end - start < 256) ? end - start : 256;
+         memcpy(bx, x + start, sizeof(double) * size);
+         memcpy(by, y + start, sizeof(double) * size);
+         memcpy(bz, z + start, sizeof(double) * size);
+         vectors_kxform(xform, rx + start, ry + start, rz + start, bx, by, bz,
+                        size, projective);
+      }
+   }
+}